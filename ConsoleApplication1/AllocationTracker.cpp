@@ -0,0 +1,277 @@
+#include "AllocationTracker.h"
+
+#if trackAllocations
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <dbghelp.h>
+#include <crtdbg.h>
+#pragma comment(lib, "dbghelp.lib")
+#else
+#include <execinfo.h>
+#endif
+
+static const char* phaseNames[PHASE_COUNT] = { "other", "input", "simulation", "upload", "draw" };
+
+// constant initialized, so they are usable from the very first allocation before main
+static thread_local AllocationPhase currentPhase = PHASE_OTHER;
+// set while the tracker itself runs, so operator new's own malloc and the report are not counted
+static thread_local bool untracked = false;
+
+static std::atomic<long> phaseAllocations[PHASE_COUNT];
+static std::atomic<long long> phaseBytes[PHASE_COUNT];
+static std::atomic<bool> steadyFrame(false);
+// The first allocating thread of a steady frame claims the trace, may be a worker. It is only
+// read once it is published, and only claimed again after that, so it is never written twice at once.
+enum TraceState { TRACE_FREE, TRACE_WRITING, TRACE_PUBLISHED };
+static std::atomic<int> traceState(TRACE_FREE);
+static const int maxTraceDepth = 32;
+static void* trace[maxTraceDepth];
+static int traceDepth = 0;
+// only written by the thread that begins and ends the frames, see allocatingSteadyFrames
+static int frameNumber = 0;
+static int steadyFramesAllocating = 0;
+
+static void recordAllocation(size_t bytes)
+{
+	if (untracked)
+	{
+		return;
+	}
+	untracked = true;
+	phaseAllocations[currentPhase]++;
+	phaseBytes[currentPhase] += bytes;
+	// the first one of a steady frame is usually enough to find the culprit
+	int unclaimed = TRACE_FREE;
+	if (steadyFrame && traceState.compare_exchange_strong(unclaimed, TRACE_WRITING))
+	{
+#ifdef _WIN32
+		traceDepth = CaptureStackBackTrace(1, maxTraceDepth, trace, NULL);
+#else
+		traceDepth = backtrace(trace, maxTraceDepth);
+#endif
+		traceState.store(TRACE_PUBLISHED, std::memory_order_release);
+	}
+	untracked = false;
+}
+
+static void* untrackedMalloc(size_t bytes)
+{
+	bool outer = untracked;
+	untracked = true;
+	void* memory = malloc(bytes != 0 ? bytes : 1);
+	untracked = outer;
+	return memory;
+}
+
+static void printTrace()
+{
+	if (traceState.load(std::memory_order_acquire) != TRACE_PUBLISHED)
+	{
+		fprintf(stderr, "    (another thread is still taking it)\n");
+		return;
+	}
+#ifdef _WIN32
+	HANDLE process = GetCurrentProcess();
+	static bool symbolsLoaded = SymInitialize(process, NULL, TRUE) != FALSE;
+	char buffer[sizeof(SYMBOL_INFO) + 256];
+	SYMBOL_INFO* symbol = (SYMBOL_INFO*)buffer;
+	for (int j = 0; j < traceDepth; j++)
+	{
+		symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+		symbol->MaxNameLen = 255;
+		DWORD64 address = (DWORD64)trace[j];
+		IMAGEHLP_LINE64 line = { sizeof(IMAGEHLP_LINE64) };
+		DWORD column = 0;
+		if (symbolsLoaded && SymFromAddr(process, address, NULL, symbol))
+		{
+			if (SymGetLineFromAddr64(process, address, &column, &line))
+			{
+				fprintf(stderr, "    %s  %s:%lu\n", symbol->Name, line.FileName, line.LineNumber);
+			}
+			else
+			{
+				fprintf(stderr, "    %s\n", symbol->Name);
+			}
+		}
+		else
+		{
+			fprintf(stderr, "    %p\n", trace[j]);
+		}
+	}
+#else
+	// straight to the descriptor, backtrace_symbols would allocate
+	fflush(stderr);
+	backtrace_symbols_fd(trace, traceDepth, 2);
+#endif
+}
+
+void setAllocationPhase(AllocationPhase phase)
+{
+	currentPhase = phase;
+}
+
+void beginAllocationFrame(bool steady)
+{
+	for (int phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		phaseAllocations[phase] = 0;
+		phaseBytes[phase] = 0;
+	}
+	// a trace still being written stays claimed, it is printed with a later frame
+	int published = TRACE_PUBLISHED;
+	traceState.compare_exchange_strong(published, TRACE_FREE, std::memory_order_acq_rel);
+	steadyFrame = steady;
+	frameNumber++;
+}
+
+void endAllocationFrame()
+{
+	long total = 0;
+	for (int phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		total += phaseAllocations[phase];
+	}
+	if (!steadyFrame || total == 0)
+	{
+		return;
+	}
+	bool outer = untracked;
+	untracked = true;
+	steadyFramesAllocating++;
+	fprintf(stderr, "frame %d allocated %ld times after warm-up:", frameNumber, total);
+	for (int phase = 0; phase < PHASE_COUNT; phase++)
+	{
+		if (phaseAllocations[phase] > 0)
+		{
+			fprintf(stderr, " %s %ld (%lld bytes)", phaseNames[phase], (long)phaseAllocations[phase], (long long)phaseBytes[phase]);
+		}
+	}
+	fprintf(stderr, "\n  first allocation from:\n");
+	printTrace();
+	untracked = outer;
+}
+
+int allocatingSteadyFrames()
+{
+	return steadyFramesAllocating;
+}
+
+void* operator new(size_t bytes)
+{
+	recordAllocation(bytes);
+	void* memory = untrackedMalloc(bytes);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void* operator new[](size_t bytes)
+{
+	return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept
+{
+	recordAllocation(bytes);
+	return untrackedMalloc(bytes);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept
+{
+	return operator new(bytes, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+// the debug CRT reports every malloc, calloc and realloc to this hook, operator new's included
+static int crtAllocationHook(int type, void*, size_t bytes, int blockType, long, const unsigned char*, int)
+{
+	if ((type == _HOOK_ALLOC || type == _HOOK_REALLOC) && blockType != _CRT_BLOCK)
+	{
+		recordAllocation(bytes);
+	}
+	return TRUE;
+}
+
+static const _CRT_ALLOC_HOOK previousHook = _CrtSetAllocHook(crtAllocationHook);
+#elif defined(__GLIBC__)
+// glibc lets the program define malloc and friends itself, the originals stay reachable
+extern "C" void* __libc_malloc(size_t bytes);
+extern "C" void* __libc_calloc(size_t count, size_t bytes);
+extern "C" void* __libc_realloc(void* memory, size_t bytes);
+
+// Only calls from the program's own code count, like the debug CRT only sees the program's
+// heap. Every library shares this malloc, and the GL driver allocates in every frame.
+extern "C" char __executable_start;
+extern "C" char etext;
+
+static bool calledFromProgram(void* address)
+{
+	return address >= (void*)&__executable_start && address < (void*)&etext;
+}
+
+extern "C" void* malloc(size_t bytes)
+{
+	if (calledFromProgram(__builtin_return_address(0)))
+	{
+		recordAllocation(bytes);
+	}
+	return __libc_malloc(bytes);
+}
+
+extern "C" void* calloc(size_t count, size_t bytes)
+{
+	if (calledFromProgram(__builtin_return_address(0)))
+	{
+		recordAllocation(count * bytes);
+	}
+	return __libc_calloc(count, bytes);
+}
+
+extern "C" void* realloc(void* memory, size_t bytes)
+{
+	if (calledFromProgram(__builtin_return_address(0)))
+	{
+		recordAllocation(bytes);
+	}
+	return __libc_realloc(memory, bytes);
+}
+#endif
+
+#endif
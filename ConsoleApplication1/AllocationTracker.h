@@ -0,0 +1,39 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+// 1 builds the allocation tracker in: AllocationTracker.cpp replaces the global operator
+// new/delete (and malloc where the runtime lets it: glibc, or the MSVC debug CRT through its
+// allocation hook) and counts every allocation by the frame phase of the allocating thread.
+// A steady frame that allocates is reported with its counts per phase and the call stack of
+// its first allocation. 0 leaves the allocators alone and the functions below do nothing.
+#define trackAllocations 0
+
+enum AllocationPhase
+{
+	PHASE_OTHER,       // threads that never set a phase, like the pool's workers, and startup
+	PHASE_INPUT,
+	PHASE_SIMULATION,
+	PHASE_UPLOAD,
+	PHASE_DRAW,
+	PHASE_COUNT
+};
+
+#if trackAllocations
+// phase of the calling thread's allocations from now on
+void setAllocationPhase(AllocationPhase phase);
+// Frames are counted on the thread that calls these, always the same one: the render thread
+// with renderThread, else the main thread. Allocations of other threads in between count for
+// the frame as well. steady = after warm-up, any allocation is a regression.
+void beginAllocationFrame(bool steady);
+void endAllocationFrame();
+// steady frames that allocated so far, nonzero fails the run. Called on the thread that
+// counts the frames or once it has been joined.
+int allocatingSteadyFrames();
+#else
+inline void setAllocationPhase(AllocationPhase) {}
+inline void beginAllocationFrame(bool) {}
+inline void endAllocationFrame() {}
+inline int allocatingSteadyFrames() { return 0; }
+#endif
+
+#endif //ALLOCATIONTRACKER_H
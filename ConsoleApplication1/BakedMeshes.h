@@ -0,0 +1,135 @@
+#ifndef BAKEDMESHES_H
+#define BAKEDMESHES_H
+
+#include "IndexBuffer.h"
+
+// Sphere tables evaluated by the compiler. With the sphere parameters fixed by #defines in
+// Mobius.cpp, a constexpr BakedSphere lands in read-only data and the program starts without
+// running a single sin, cos or push_back for it:
+//   static constexpr BakedSphere<stacks, slices> bakedEarth = bakeSphere<stacks, slices>(radius);
+// The layout is the one of calculateSphereVertices, calculateEarthNormals,
+// GenerateSphereTexCoordinates, gridTriangleStrips and stripsToTriangles.
+
+constexpr double bakedPi = 3.14159265358979323846;
+
+// std::sin is not constexpr, so reduce to [-pi, pi] and sum a Taylor series. Twelve terms are
+// exact to double precision on that interval.
+constexpr double bakedSin(double x)
+{
+	while (x > bakedPi)
+	{
+		x -= 2.0 * bakedPi;
+	}
+	while (x < -bakedPi)
+	{
+		x += 2.0 * bakedPi;
+	}
+	double term = x;
+	double sum = x;
+	for (int n = 1; n < 12; n++)
+	{
+		term *= -x * x / ((2 * n) * (2 * n + 1));
+		sum += term;
+	}
+	return sum;
+}
+
+constexpr double bakedCos(double x)
+{
+	return bakedSin(x + 0.5 * bakedPi);
+}
+
+// std::array is only writable in constant expressions from C++17 on
+template <typename T, int N>
+struct BakedArray
+{
+	T values[N];
+
+	static const int count = N;
+	constexpr const T& operator[](int j) const { return values[j]; }
+	constexpr const T* begin() const { return values; }
+	constexpr const T* end() const { return values + N; }
+};
+
+template <int Stacks, int Slices>
+struct BakedSphere
+{
+	static const int vertexCount = (Stacks + 1) * (Slices + 1);
+	static const int triangleCount = Stacks * Slices * 2;
+	static const int stripLength = Stacks * (Slices + 1) * 2 + Stacks - 1;
+
+	BakedArray<float, vertexCount * 3> positions;  // around the origin
+	BakedArray<float, vertexCount * 3> normals;
+	BakedArray<float, vertexCount * 2> texCoords;
+	BakedArray<int, triangleCount * 3> triangles;
+	BakedArray<int, stripLength> strips;           // one strip per stack, separated by stripRestart
+};
+
+template <int Stacks, int Slices>
+constexpr BakedSphere<Stacks, Slices> bakeSphere(double sphereRadius)
+{
+	static_assert(BakedSphere<Stacks, Slices>::vertexCount <= 0xFFFF, "baked spheres are meant for 16 bit indices");
+	BakedSphere<Stacks, Slices> sphere = {};
+
+	// one sin and cos per stack and per slice instead of per vertex
+	double sinTheta[Stacks + 1] = {};
+	double cosTheta[Stacks + 1] = {};
+	double sinPhi[Slices + 1] = {};
+	double cosPhi[Slices + 1] = {};
+	for (int stack = 0; stack <= Stacks; stack++)
+	{
+		sinTheta[stack] = bakedSin(stack * bakedPi / Stacks);
+		cosTheta[stack] = bakedCos(stack * bakedPi / Stacks);
+	}
+	for (int slice = 0; slice <= Slices; slice++)
+	{
+		sinPhi[slice] = bakedSin(slice * 2.0 * bakedPi / Slices);
+		cosPhi[slice] = bakedCos(slice * 2.0 * bakedPi / Slices);
+	}
+
+	int vertex = 0;
+	for (int stack = 0; stack <= Stacks; stack++)
+	{
+		for (int slice = 0; slice <= Slices; slice++)
+		{
+			double normal[3] = { cosPhi[slice] * sinTheta[stack], sinPhi[slice] * sinTheta[stack], cosTheta[stack] };
+			for (int axis = 0; axis < 3; axis++)
+			{
+				sphere.positions.values[vertex * 3 + axis] = (float)(sphereRadius * normal[axis]);
+				sphere.normals.values[vertex * 3 + axis] = (float)normal[axis];
+			}
+			sphere.texCoords.values[vertex * 2] = (float)slice / Slices;
+			sphere.texCoords.values[vertex * 2 + 1] = 1.0f - (float)stack / Stacks;
+			vertex++;
+		}
+	}
+
+	int strip = 0;
+	int triangle = 0;
+	for (int stack = 0; stack < Stacks; stack++)
+	{
+		if (stack > 0)
+		{
+			sphere.strips.values[strip++] = stripRestart;
+		}
+		for (int corner = 0; corner < 2 * (Slices + 1); corner++)
+		{
+			int column = corner / 2;
+			int index = (stack + corner % 2) * (Slices + 1) + column;
+			sphere.strips.values[strip++] = index;
+			if (corner < 2)
+			{
+				continue;
+			}
+			// every second triangle of a strip is wound the other way round
+			int a = sphere.strips.values[strip - 3];
+			int b = sphere.strips.values[strip - 2];
+			sphere.triangles.values[triangle++] = corner % 2 == 1 ? b : a;
+			sphere.triangles.values[triangle++] = corner % 2 == 1 ? a : b;
+			sphere.triangles.values[triangle++] = index;
+		}
+	}
+	return sphere;
+}
+
+#endif //BAKEDMESHES_H
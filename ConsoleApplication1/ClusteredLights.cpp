@@ -0,0 +1,184 @@
+#include "ClusteredLights.h"
+#include "Shader.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+static_assert(clusterCount % 64 == 0, "the cluster pass runs whole groups of 64 clusters");
+
+const GLchar* computeClusterShaderSource =
+"#version 440 core\n"
+"layout(local_size_x = 64) in;"
+""
+"layout(std430, binding = 10) readonly buffer Lights { vec4 lights[]; };"
+"layout(std430, binding = 11) writeonly buffer ClusterRanges { uvec2 clusterRanges[]; };"
+"layout(std430, binding = 12) buffer LightIndices { uint lightIndexCount; uint lightIndices[]; };"
+""
+"uniform mat4 view;"
+"uniform mat4 inverseProjection;"
+"uniform int lightCount;"
+"uniform uvec3 clusterGrid;"
+"uniform float nearPlane;"
+"uniform float farPlane;"
+"uniform uint indexCapacity;"
+""
+// the lights of one batch in view space, shared by the group's 64 clusters
+"shared vec4 batch[64];"
+""
+"vec3 lower;"
+"vec3 upper;"
+""
+"vec3 viewPoint(vec2 ndc, float depth)"
+"{"
+"	vec4 point = inverseProjection * vec4(ndc, -1.0, 1.0);"
+"	point /= point.w;"
+"	return point.xyz * (depth / -point.z);"
+"}"
+""
+// the lights whose range reaches the box of the cluster, written from offset on up to
+// capacity of them if write is set. Every invocation of the group has to call it alike.
+"uint countLights(bool write, uint offset, uint capacity)"
+"{"
+"	uint count = 0u;"
+"	for (int first = 0; first < lightCount; first += 64)"
+"	{"
+"		int light = first + int(gl_LocalInvocationIndex);"
+"		if (light < lightCount)"
+"		{"
+"			vec4 positionRange = lights[light * 2];"
+"			batch[gl_LocalInvocationIndex] = vec4((view * vec4(positionRange.xyz, 1.0)).xyz, positionRange.w);"
+"		}"
+"		barrier();"
+"		int batchSize = min(64, lightCount - first);"
+"		for (int k = 0; k < batchSize; k++)"
+"		{"
+			// closest point of the box to the light's center, inside its range or not
+"			vec4 sphere = batch[k];"
+"			vec3 offsetToBox = clamp(sphere.xyz, lower, upper) - sphere.xyz;"
+"			if (dot(offsetToBox, offsetToBox) <= sphere.w * sphere.w)"
+"			{"
+"				if (write && count < capacity)"
+"				{"
+"					lightIndices[offset + count] = uint(first + k);"
+"				}"
+"				count++;"
+"			}"
+"		}"
+"		barrier();"
+"	}"
+"	return count;"
+"}"
+""
+"void main()"
+"{"
+"	uint cluster = gl_GlobalInvocationID.x;"
+"	uint x = cluster % clusterGrid.x;"
+"	uint y = (cluster / clusterGrid.x) % clusterGrid.y;"
+"	uint z = cluster / (clusterGrid.x * clusterGrid.y);"
+""
+	// bounding box of the cluster's piece of the frustum
+"	float sliceNear = nearPlane * pow(farPlane / nearPlane, float(z) / float(clusterGrid.z));"
+"	float sliceFar = nearPlane * pow(farPlane / nearPlane, float(z + 1u) / float(clusterGrid.z));"
+"	vec2 ndcMin = vec2(x, y) / vec2(clusterGrid.xy) * 2.0 - 1.0;"
+"	vec2 ndcMax = vec2(x + 1u, y + 1u) / vec2(clusterGrid.xy) * 2.0 - 1.0;"
+"	lower = vec3(1e30);"
+"	upper = vec3(-1e30);"
+"	for (int corner = 0; corner < 8; corner++)"
+"	{"
+"		vec2 ndc = vec2((corner & 1) != 0 ? ndcMax.x : ndcMin.x, (corner & 2) != 0 ? ndcMax.y : ndcMin.y);"
+"		vec3 point = viewPoint(ndc, (corner & 4) != 0 ? sliceFar : sliceNear);"
+"		lower = min(lower, point);"
+"		upper = max(upper, point);"
+"	}"
+""
+	// count the lights first, then take a range of the list and write them in a second round
+"	uint count = countLights(false, 0u, 0u);"
+"	uint offset = atomicAdd(lightIndexCount, count);"
+"	count = offset < indexCapacity ? min(count, indexCapacity - offset) : 0u;"
+"	clusterRanges[cluster] = uvec2(offset, count);"
+"	countLights(true, offset, count);"
+"}";
+
+ClusteredLights createClusteredLights(int lightCount, float nearPlane, float farPlane)
+{
+	ClusteredLights lighting;
+	lighting.indexCapacity = lightCount * clustersPerLight;
+	lighting.nearPlane = nearPlane;
+	lighting.farPlane = farPlane;
+	lighting.program = createComputeProgram(computeClusterShaderSource);
+	glGenBuffers(1, &lighting.rangeBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lighting.rangeBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * 2 * clusterCount, nullptr, GL_DYNAMIC_COPY);
+	glGenBuffers(1, &lighting.indexBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lighting.indexBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * (1 + lighting.indexCapacity), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return lighting;
+}
+
+void assignLightsToClusters(const ClusteredLights& lighting, int lightCount, const glm::mat4& view, const glm::mat4& projection)
+{
+	unsigned int program = lighting.program;
+	glm::mat4 inverseProjection = glm::inverse(projection);
+	glUseProgram(program);
+	glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, &view[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(program, "inverseProjection"), 1, GL_FALSE, &inverseProjection[0][0]);
+	glUniform1i(glGetUniformLocation(program, "lightCount"), lightCount);
+	glUniform3ui(glGetUniformLocation(program, "clusterGrid"), clusterCountX, clusterCountY, clusterCountZ);
+	glUniform1f(glGetUniformLocation(program, "nearPlane"), lighting.nearPlane);
+	glUniform1f(glGetUniformLocation(program, "farPlane"), lighting.farPlane);
+	glUniform1ui(glGetUniformLocation(program, "indexCapacity"), lighting.indexCapacity);
+	// the list starts empty in every frame
+	GLuint zero = 0;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lighting.indexBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint), &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CLUSTER_RANGE_BINDING, lighting.rangeBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_INDEX_BINDING, lighting.indexBuffer);
+	glDispatchCompute(clusterCount / 64, 1, 1);
+	// the fragment shaders read the clusters as storage
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void setClusterUniforms(unsigned int program, const ClusteredLights& lighting, int viewportWidth, int viewportHeight)
+{
+	// slice = log(depth / near) / log(far / near) * slices, split into a scale and a bias on log(depth)
+	float logRange = std::log(lighting.farPlane / lighting.nearPlane);
+	glUseProgram(program);
+	glUniform3ui(glGetUniformLocation(program, "clusterGrid"), clusterCountX, clusterCountY, clusterCountZ);
+	glUniform2f(glGetUniformLocation(program, "clusterTileSize"), (float)viewportWidth / clusterCountX, (float)viewportHeight / clusterCountY);
+	glUniform1f(glGetUniformLocation(program, "clusterSliceScale"), clusterCountZ / logRange);
+	glUniform1f(glGetUniformLocation(program, "clusterSliceBias"), -clusterCountZ * std::log(lighting.nearPlane) / logRange);
+}
+
+// the same pseudo random numbers for a light in every frame, so nothing has to be stored
+static float lightRandom(int light, int salt)
+{
+	unsigned int hash = (unsigned int)light * 747796405u + (unsigned int)salt * 2891336453u;
+	hash = ((hash >> ((hash >> 28) + 4)) ^ hash) * 277803737u;
+	hash = (hash >> 22) ^ hash;
+	return (float)(hash & 0xffffff) / (float)0x1000000;
+}
+
+void fillOrbitingLights(Span<float> lights, int count, float time)
+{
+	for (int light = 0; light < count; light++)
+	{
+		float orbit = 0.6f + 1.4f * lightRandom(light, 0);
+		float height = (lightRandom(light, 1) - 0.5f) * 1.2f;
+		float speed = (0.2f + 0.6f * lightRandom(light, 2)) * (lightRandom(light, 3) < 0.5f ? -1.0f : 1.0f);
+		float angle = lightRandom(light, 4) * 6.2831853f + speed * time;
+		float* out = &lights[light * lightFloats];
+		out[0] = orbit * std::cos(angle);
+		out[1] = orbit * std::sin(angle);
+		out[2] = height;
+		out[3] = 0.25f + 0.2f * lightRandom(light, 5);
+		// a saturated hue, bright enough to show on the textures
+		float hue = lightRandom(light, 6) * 6.0f;
+		out[4] = glm::clamp(std::abs(hue - 3.0f) - 1.0f, 0.0f, 1.0f) * 1.5f;
+		out[5] = glm::clamp(2.0f - std::abs(hue - 2.0f), 0.0f, 1.0f) * 1.5f;
+		out[6] = glm::clamp(2.0f - std::abs(hue - 4.0f), 0.0f, 1.0f) * 1.5f;
+		out[7] = 0.0f;
+	}
+}
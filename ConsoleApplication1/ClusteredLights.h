@@ -0,0 +1,94 @@
+#ifndef CLUSTEREDLIGHTS_H
+#define CLUSTEREDLIGHTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Span.h"
+
+// Clustered forward lighting for many point lights. The view frustum is cut into
+// clusterCountX * clusterCountY screen tiles and clusterCountZ slices that grow exponentially
+// with the distance, like the depth precision does. A compute pass tests every light's sphere
+// of influence against every cluster's bounds once per frame and appends the indices of the
+// lights that reach it to one list shared by all clusters, taking its range of the list with
+// an atomic counter. A fragment then only loops over the lights of its own cluster, so its cost
+// follows how many lights overlap there and not how many there are in total. A cluster holds
+// as many lights as reach it, crowded ones included.
+static const int clusterCountX = 16;
+static const int clusterCountY = 16;
+static const int clusterCountZ = 24;
+static const int clusterCount = clusterCountX * clusterCountY * clusterCountZ;
+// The index list has room for this many clusters per light on average. The default scene uses
+// about a seventh of that; a frame that still runs out keeps every cluster's lights up to the end
+// of the list and leaves the clusters after it unlit by the point lights.
+static const int clustersPerLight = 256;
+// floats per light in the light buffer: position and range, then color
+static const int lightFloats = 8;
+
+// Shader storage bindings: the lights, the (offset, count) of every cluster in the index list,
+// and the index list behind its counter. Both the cluster pass and the fragment shaders read
+// them, the GLSL below spells out the same numbers.
+#define LIGHT_BINDING 10
+#define CLUSTER_RANGE_BINDING 11
+#define LIGHT_INDEX_BINDING 12
+
+// GLSL for a fragment shader: the buffers, the grid uniforms and
+// vec3 clusteredLighting(vec3 fragPos, vec3 norm), the diffuse light of every point light of
+// the fragment's cluster. Pasted into the fragment shader sources of Mobius.cpp, so it has to
+// stay a string literal. The program needs uniform mat4 view, which the vertex shaders have.
+#define CLUSTERED_LIGHTING_GLSL \
+"layout(std430, binding = 10) readonly buffer Lights { vec4 lights[]; };" \
+"layout(std430, binding = 11) readonly buffer ClusterRanges { uvec2 clusterRanges[]; };" \
+"layout(std430, binding = 12) readonly buffer LightIndices { uint lightIndexCount; uint lightIndices[]; };" \
+"" \
+"uniform mat4 view;" \
+"uniform uvec3 clusterGrid;" \
+"uniform vec2 clusterTileSize;" \
+"uniform float clusterSliceScale;" \
+"uniform float clusterSliceBias;" \
+"" \
+"vec3 clusteredLighting(vec3 fragPos, vec3 norm)" \
+"{" \
+"	float depth = -(view * vec4(fragPos, 1.0)).z;" \
+"	uint slice = uint(clamp(log(max(depth, 1e-4)) * clusterSliceScale + clusterSliceBias, 0.0, float(clusterGrid.z - 1u)));" \
+"	uvec2 tile = min(uvec2(gl_FragCoord.xy / clusterTileSize), clusterGrid.xy - 1u);" \
+"	uint cluster = (slice * clusterGrid.y + tile.y) * clusterGrid.x + tile.x;" \
+"	uvec2 range = clusterRanges[cluster];" \
+"	vec3 total = vec3(0.0);" \
+"	for (uint k = 0u; k < range.y; k++)" \
+"	{" \
+"		uint light = lightIndices[range.x + k];" \
+"		vec4 positionRange = lights[light * 2u];" \
+"		vec3 toLight = positionRange.xyz - fragPos;" \
+"		float distance = length(toLight);" \
+"		float falloff = max(1.0 - distance / positionRange.w, 0.0);" \
+"		total += lights[light * 2u + 1u].rgb * (max(dot(norm, toLight / max(distance, 1e-4)), 0.0) * falloff * falloff);" \
+"	}" \
+"	return total;" \
+"}"
+
+struct ClusteredLights
+{
+	GLuint rangeBuffer;
+	GLuint indexBuffer;     // the counter, then indexCapacity light indices
+	int indexCapacity;
+	unsigned int program;
+	float nearPlane;
+	float farPlane;
+};
+
+// for up to lightCount lights, the clusters span the projection's near to far plane
+ClusteredLights createClusteredLights(int lightCount, float nearPlane, float farPlane);
+
+// Bins lightCount lights of the light buffer bound at LIGHT_BINDING into the clusters of this
+// frame's view and binds the cluster buffers for the fragment shaders.
+void assignLightsToClusters(const ClusteredLights& lighting, int lightCount, const glm::mat4& view, const glm::mat4& projection);
+
+// the grid uniforms of a program using CLUSTERED_LIGHTING_GLSL, again whenever the viewport changes
+void setClusterUniforms(unsigned int program, const ClusteredLights& lighting, int viewportWidth, int viewportHeight);
+
+// count lights on circles around the z axis through the scene, each at its own radius, height,
+// speed and color, at the given time. lightFloats floats per light.
+void fillOrbitingLights(Span<float> lights, int count, float time);
+
+#endif //CLUSTEREDLIGHTS_H
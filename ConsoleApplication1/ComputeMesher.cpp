@@ -0,0 +1,154 @@
+#include "ComputeMesher.h"
+#include "Shader.h"
+
+const GLchar* computeMobiusShaderSource =
+"#version 440 core\n"
+"layout(local_size_x = 64) in;"
+""
+"layout(std430, binding = 0) writeonly buffer Coords { float coords[]; };"
+"layout(std430, binding = 1) writeonly buffer Normals { float normals[]; };"
+"layout(std430, binding = 2) writeonly buffer TexCoords { float texCoords[]; };"
+""
+"uniform int segments;"
+"uniform int rows;"
+"uniform float stepSize;"
+"uniform float width;"
+"uniform int baseVertex;"
+"uniform int coordsBase;"
+"uniform int normalsBase;"
+"uniform int texCoordsBase;"
+"uniform bool writeTexCoords;"
+""
+"void main()"
+"{"
+"	int id = int(gl_GlobalInvocationID.x);"
+"	if (id >= segments * rows) return;"
+"	int segment = id / rows;"
+"	int row = id % rows;"
+""
+"	float a = float(segment) * stepSize;"
+"	float s = mix(-width, width, float(row) / float(rows - 1));"
+"	float cosHalf = cos(0.5 * a);"
+"	float sinHalf = sin(0.5 * a);"
+"	float r = 1.0 + s * cosHalf;"
+""
+"	vec3 position = vec3(r * cos(a), r * sin(a), s * sinHalf);"
+	// partial derivatives along the strip and across its width
+"	vec3 dA = vec3(-r * sin(a) - 0.5 * s * sinHalf * cos(a), r * cos(a) - 0.5 * s * sinHalf * sin(a), 0.5 * s * cosHalf);"
+"	vec3 dS = vec3(cosHalf * cos(a), cosHalf * sin(a), sinHalf);"
+"	vec3 normal = normalize(cross(dA, dS));"
+""
+"	int v = baseVertex + id;"
+"	coords[coordsBase + v * 3] = position.x;"
+"	coords[coordsBase + v * 3 + 1] = position.y;"
+"	coords[coordsBase + v * 3 + 2] = position.z;"
+"	normals[normalsBase + v * 3] = normal.x;"
+"	normals[normalsBase + v * 3 + 1] = normal.y;"
+"	normals[normalsBase + v * 3 + 2] = normal.z;"
+"	if (writeTexCoords)"
+"	{"
+"		texCoords[texCoordsBase + v * 2] = a / 6.28318530718;"
+"		texCoords[texCoordsBase + v * 2 + 1] = float(row) / float(rows - 1);"
+"	}"
+"}";
+
+const GLchar* computeSphereShaderSource =
+"#version 440 core\n"
+"layout(local_size_x = 64) in;"
+""
+"layout(std430, binding = 0) writeonly buffer Coords { float coords[]; };"
+"layout(std430, binding = 1) writeonly buffer Normals { float normals[]; };"
+"layout(std430, binding = 2) writeonly buffer TexCoords { float texCoords[]; };"
+""
+"uniform int stacks;"
+"uniform int slices;"
+"uniform float radius;"
+"uniform vec3 center;"
+"uniform float rotation;"
+"uniform int baseVertex;"
+"uniform int coordsBase;"
+"uniform int normalsBase;"
+"uniform int texCoordsBase;"
+"uniform bool writeTexCoords;"
+""
+"void main()"
+"{"
+"	int id = int(gl_GlobalInvocationID.x);"
+"	if (id >= (stacks + 1) * (slices + 1)) return;"
+"	int stackNumber = id / (slices + 1);"
+"	int sliceNumber = id % (slices + 1);"
+""
+"	float theta = float(stackNumber) * 3.14159265359 / float(stacks);"
+"	float phi = float(sliceNumber) * 6.28318530718 / float(slices) + rotation;"
+"	vec3 normal = vec3(cos(phi) * sin(theta), sin(phi) * sin(theta), cos(theta));"
+"	vec3 position = center + radius * normal;"
+""
+"	int v = baseVertex + id;"
+"	coords[coordsBase + v * 3] = position.x;"
+"	coords[coordsBase + v * 3 + 1] = position.y;"
+"	coords[coordsBase + v * 3 + 2] = position.z;"
+"	normals[normalsBase + v * 3] = normal.x;"
+"	normals[normalsBase + v * 3 + 1] = normal.y;"
+"	normals[normalsBase + v * 3 + 2] = normal.z;"
+"	if (writeTexCoords)"
+"	{"
+"		texCoords[texCoordsBase + v * 2] = float(sliceNumber) / float(slices);"
+"		texCoords[texCoordsBase + v * 2 + 1] = 1.0 - float(stackNumber) / float(stacks);"
+"	}"
+"}";
+
+unsigned int createMobiusMesher()
+{
+	return createComputeProgram(computeMobiusShaderSource);
+}
+
+unsigned int createSphereMesher()
+{
+	return createComputeProgram(computeSphereShaderSource);
+}
+
+static void bindTarget(unsigned int program, const MesherTarget& target)
+{
+	glUniform1i(glGetUniformLocation(program, "baseVertex"), target.baseVertex);
+	glUniform1i(glGetUniformLocation(program, "coordsBase"), target.coordsOffset / sizeof(float));
+	glUniform1i(glGetUniformLocation(program, "normalsBase"), target.normalsOffset / sizeof(float));
+	glUniform1i(glGetUniformLocation(program, "texCoordsBase"), target.texCoordsOffset / sizeof(float));
+	glUniform1i(glGetUniformLocation(program, "writeTexCoords"), target.texCoords != 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, target.coords);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, target.normals);
+	if (target.texCoords != 0)
+	{
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, target.texCoords);
+	}
+}
+
+void dispatchMobiusMesher(unsigned int program, const MesherTarget& target, int segments, int rows, float stepSize, float width)
+{
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "segments"), segments);
+	glUniform1i(glGetUniformLocation(program, "rows"), rows);
+	glUniform1f(glGetUniformLocation(program, "stepSize"), stepSize);
+	glUniform1f(glGetUniformLocation(program, "width"), width);
+	bindTarget(program, target);
+
+	int vertexCount = segments * rows;
+	glDispatchCompute((vertexCount + 63) / 64, 1, 1);
+	// the next draw reads the buffers as vertex attributes, or from the arena's storage buffer with vertexPulling
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void dispatchSphereMesher(unsigned int program, const MesherTarget& target, int sphereStacks, int sphereSlices, float sphereRadius, glm::vec3 center, float rotation)
+{
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "stacks"), sphereStacks);
+	glUniform1i(glGetUniformLocation(program, "slices"), sphereSlices);
+	glUniform1f(glGetUniformLocation(program, "radius"), sphereRadius);
+	glUniform3f(glGetUniformLocation(program, "center"), center.x, center.y, center.z);
+	glUniform1f(glGetUniformLocation(program, "rotation"), rotation);
+	bindTarget(program, target);
+
+	int vertexCount = (sphereStacks + 1) * (sphereSlices + 1);
+	glDispatchCompute((vertexCount + 63) / 64, 1, 1);
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
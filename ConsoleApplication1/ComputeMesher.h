@@ -0,0 +1,32 @@
+#ifndef COMPUTEMESHER_H
+#define COMPUTEMESHER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Buffers a mesher dispatch writes into. The buffers are ordinary vertex buffers that get
+// bound as shader storage while the compute shader runs, so they stay usable in any VAO.
+// positions and normals are tightly packed vec3 floats, texcoords tightly packed vec2 floats.
+// The byte offsets allow several attributes to live in regions of one buffer.
+struct MesherTarget
+{
+	GLuint coords;
+	GLuint normals;
+	GLuint texCoords;   // 0 if the mesh has no texture coordinates
+	GLuint baseVertex;  // first vertex written inside the buffers
+	GLuint coordsOffset;
+	GLuint normalsOffset;
+	GLuint texCoordsOffset;
+};
+
+unsigned int createMobiusMesher();
+unsigned int createSphereMesher();
+
+// Möbius strip sampled like calculateMobiusVertices: "segments" steps of "stepSize" along the strip,
+// "rows" vertices across the width (2 = inner and outer edge)
+void dispatchMobiusMesher(unsigned int program, const MesherTarget& target, int segments, int rows, float stepSize, float width);
+
+// UV sphere laid out like calculateSphereVertices, rotated around z by "rotation" and moved to "center"
+void dispatchSphereMesher(unsigned int program, const MesherTarget& target, int sphereStacks, int sphereSlices, float sphereRadius, glm::vec3 center, float rotation);
+
+#endif //COMPUTEMESHER_H
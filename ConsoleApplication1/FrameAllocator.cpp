@@ -0,0 +1,37 @@
+#include "FrameAllocator.h"
+
+#include <stdint.h>
+
+static void* alignPointer(char* memory, size_t alignment)
+{
+	uintptr_t address = (uintptr_t)memory;
+	return (void*)((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+}
+
+void* arenaAllocate(LinearArena& arena, size_t bytes, size_t alignment)
+{
+	// room for the worst alignment, so the bump itself needs no compare and swap
+	size_t padded = bytes + alignment - 1;
+	size_t offset = arena.used.fetch_add(padded);
+	if (offset + padded <= arena.capacity)
+	{
+		return alignPointer(arena.block.get() + offset, alignment);
+	}
+	// past the block, the next reset grows it so this only happens while warming up
+	std::lock_guard<std::mutex> lock(arena.overflowMutex);
+	arena.overflow.push_back(std::unique_ptr<char[]>(new char[padded]));
+	return alignPointer(arena.overflow.back().get(), alignment);
+}
+
+void resetLinearArena(LinearArena& arena)
+{
+	size_t needed = arena.used;
+	if (needed > arena.capacity)
+	{
+		// with headroom, a frame that needs a little more than the last one does not grow it again
+		arena.capacity = needed + needed / 2;
+		arena.block.reset(new char[arena.capacity]);
+		arena.overflow.clear();
+	}
+	arena.used = 0;
+}
@@ -0,0 +1,56 @@
+#ifndef FRAMEALLOCATOR_H
+#define FRAMEALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Bump allocator for data that lives for one frame at most. Allocating moves an offset
+// through one block and freeing is a single reset for everything at once, so transient arrays
+// and job closures cost no heap traffic. The offset is atomic, jobs on any thread allocate
+// from the same arena; resetting must not overlap with allocations.
+// A frame that needs more than the block gets heap blocks for the rest, and the next reset
+// replaces the block by one large enough for it. After a few frames of warm-up the arena
+// does not touch the heap any more.
+struct LinearArena
+{
+	std::unique_ptr<char[]> block;
+	size_t capacity = 0;
+	std::atomic<size_t> used{ 0 };  // can run past capacity, then it is what the frame needed
+	std::mutex overflowMutex;
+	std::vector<std::unique_ptr<char[]>> overflow;
+};
+
+// alignment is a power of two. The memory stays valid until the next resetLinearArena.
+void* arenaAllocate(LinearArena& arena, size_t bytes, size_t alignment);
+// Frees everything at once; destructors of what was built in the arena do not run.
+void resetLinearArena(LinearArena& arena);
+
+// For standard containers that only live within the frame, like
+// std::vector<float, ArenaAllocator<float>>. deallocate gives nothing back, the reset does.
+template<typename T>
+struct ArenaAllocator
+{
+	typedef T value_type;
+
+	LinearArena* arena;
+
+	explicit ArenaAllocator(LinearArena& arena) : arena(&arena) {}
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+	T* allocate(size_t count) { return (T*)arenaAllocate(*arena, count * sizeof(T), alignof(T)); }
+	void deallocate(T*, size_t) {}
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena == b.arena; }
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena != b.arena; }
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif //FRAMEALLOCATOR_H
@@ -0,0 +1,134 @@
+#include "GpuAllocator.h"
+
+GpuAllocator createGpuAllocator(int capacity)
+{
+	GpuAllocator allocator;
+	allocator.capacity = capacity;
+	GpuBlock all = { 0, capacity };
+	allocator.freeBlocks.push_back(all);
+	return allocator;
+}
+
+int allocateBlock(GpuAllocator& allocator, int size, int alignment)
+{
+	if (size <= 0)
+	{
+		return -1;
+	}
+
+	for (int j = 0; j < (int)allocator.freeBlocks.size(); j++)
+	{
+		GpuBlock block = allocator.freeBlocks[j];
+		int offset = (block.offset + alignment - 1) / alignment * alignment;
+		int padding = offset - block.offset;
+		if (padding + size > block.size)
+		{
+			continue;
+		}
+
+		// the padding in front stays free, whatever is left behind the block too
+		allocator.freeBlocks.erase(allocator.freeBlocks.begin() + j);
+		int end = block.offset + block.size;
+		if (end > offset + size)
+		{
+			GpuBlock rest = { offset + size, end - offset - size };
+			allocator.freeBlocks.insert(allocator.freeBlocks.begin() + j, rest);
+		}
+		if (padding > 0)
+		{
+			GpuBlock front = { block.offset, padding };
+			allocator.freeBlocks.insert(allocator.freeBlocks.begin() + j, front);
+		}
+
+		GpuAllocation allocation = { size, alignment };
+		allocator.usedBlocks[offset] = allocation;
+		return offset;
+	}
+	return -1;
+}
+
+void freeBlock(GpuAllocator& allocator, int offset)
+{
+	std::map<int, GpuAllocation>::iterator used = allocator.usedBlocks.find(offset);
+	if (used == allocator.usedBlocks.end())
+	{
+		return;
+	}
+	GpuBlock block = { offset, used->second.size };
+	allocator.usedBlocks.erase(used);
+
+	// insert sorted, then merge with the neighbours on both sides
+	int j = 0;
+	while (j < (int)allocator.freeBlocks.size() && allocator.freeBlocks[j].offset < offset)
+	{
+		j++;
+	}
+	allocator.freeBlocks.insert(allocator.freeBlocks.begin() + j, block);
+
+	if (j + 1 < (int)allocator.freeBlocks.size() && block.offset + block.size == allocator.freeBlocks[j + 1].offset)
+	{
+		allocator.freeBlocks[j].size += allocator.freeBlocks[j + 1].size;
+		allocator.freeBlocks.erase(allocator.freeBlocks.begin() + j + 1);
+	}
+	if (j > 0 && allocator.freeBlocks[j - 1].offset + allocator.freeBlocks[j - 1].size == allocator.freeBlocks[j].offset)
+	{
+		allocator.freeBlocks[j - 1].size += allocator.freeBlocks[j].size;
+		allocator.freeBlocks.erase(allocator.freeBlocks.begin() + j);
+	}
+}
+
+int freeSpace(const GpuAllocator& allocator)
+{
+	int space = 0;
+	for (const GpuBlock& block : allocator.freeBlocks)
+	{
+		space += block.size;
+	}
+	return space;
+}
+
+int largestFreeBlock(const GpuAllocator& allocator)
+{
+	int largest = 0;
+	for (const GpuBlock& block : allocator.freeBlocks)
+	{
+		if (block.size > largest)
+		{
+			largest = block.size;
+		}
+	}
+	return largest;
+}
+
+std::vector<GpuMove> defragmentAllocator(GpuAllocator& allocator)
+{
+	std::vector<GpuMove> moves;
+	std::map<int, GpuAllocation> packed;
+	std::vector<GpuBlock> gaps;
+	int end = 0;
+	for (const std::pair<const int, GpuAllocation>& used : allocator.usedBlocks)
+	{
+		int offset = (end + used.second.alignment - 1) / used.second.alignment * used.second.alignment;
+		if (offset > end)
+		{
+			GpuBlock gap = { end, offset - end };
+			gaps.push_back(gap);
+		}
+		if (used.first != offset)
+		{
+			GpuMove move = { used.first, offset, used.second.size };
+			moves.push_back(move);
+		}
+		packed[offset] = used.second;
+		end = offset + used.second.size;
+	}
+
+	allocator.usedBlocks = packed;
+	allocator.freeBlocks = gaps;
+	if (end < allocator.capacity)
+	{
+		GpuBlock rest = { end, allocator.capacity - end };
+		allocator.freeBlocks.push_back(rest);
+	}
+	return moves;
+}
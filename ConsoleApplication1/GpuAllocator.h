@@ -0,0 +1,49 @@
+#ifndef GPUALLOCATOR_H
+#define GPUALLOCATOR_H
+
+#include <map>
+#include <vector>
+
+// Hands out ranges of a buffer that already exists on the GPU, it never touches GL itself.
+// Offsets and sizes are in whatever unit the caller picks (vertices, indices, bytes).
+struct GpuBlock
+{
+	int offset;
+	int size;
+};
+
+// one live block that defragmentAllocator moved, the caller copies the data accordingly
+struct GpuMove
+{
+	int from;
+	int to;
+	int size;
+};
+
+struct GpuAllocation
+{
+	int size;
+	int alignment;  // kept so defragmentation can honour it again
+};
+
+struct GpuAllocator
+{
+	int capacity;
+	std::vector<GpuBlock> freeBlocks;         // sorted by offset, neighbours are always merged
+	std::map<int, GpuAllocation> usedBlocks;  // by offset
+};
+
+GpuAllocator createGpuAllocator(int capacity);
+
+// first fit, returns -1 if no free block is large enough
+int allocateBlock(GpuAllocator& allocator, int size, int alignment = 1);
+void freeBlock(GpuAllocator& allocator, int offset);
+
+int freeSpace(const GpuAllocator& allocator);
+int largestFreeBlock(const GpuAllocator& allocator);
+
+// packs every used block to the front in offset order, so every move goes to a lower offset.
+// Aligned blocks may leave small gaps in front of them, those stay in the free list.
+std::vector<GpuMove> defragmentAllocator(GpuAllocator& allocator);
+
+#endif //GPUALLOCATOR_H
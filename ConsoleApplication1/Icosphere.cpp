@@ -0,0 +1,173 @@
+#include "Icosphere.h"
+
+#include <algorithm>
+#include <map>
+#include <math.h>
+#include <utility>
+
+static const float icospherePi = 3.14159265358979f;
+
+static int midpoint(std::map<std::pair<int, int>, int>& cache, std::vector<glm::vec3>& vertices, int a, int b)
+{
+	std::pair<int, int> edge = a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+	std::map<std::pair<int, int>, int>::iterator cached = cache.find(edge);
+	if (cached != cache.end())
+	{
+		return cached->second;
+	}
+	vertices.push_back(glm::normalize(vertices[a] + vertices[b]));
+	int index = vertices.size() - 1;
+	cache[edge] = index;
+	return index;
+}
+
+IcosphereMesh createIcosphere(int subdivisions)
+{
+	// poles, then an upper and a lower ring of five at +-atan(1/2) latitude, the lower one turned by 36 degrees
+	std::vector<glm::vec3> vertices;
+	float latitude = atan(0.5f);
+	vertices.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+	for (int k = 0; k < 5; k++)
+	{
+		float longitude = k * 2 * icospherePi / 5;
+		vertices.push_back(glm::vec3(cos(latitude) * cos(longitude), cos(latitude) * sin(longitude), sin(latitude)));
+	}
+	for (int k = 0; k < 5; k++)
+	{
+		float longitude = (k + 0.5f) * 2 * icospherePi / 5;
+		vertices.push_back(glm::vec3(cos(latitude) * cos(longitude), cos(latitude) * sin(longitude), -sin(latitude)));
+	}
+	vertices.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+
+	std::vector<int> triangles;
+	for (int k = 0; k < 5; k++)
+	{
+		int upper = 1 + k;
+		int upperNext = 1 + (k + 1) % 5;
+		int lower = 6 + k;
+		int lowerNext = 6 + (k + 1) % 5;
+		int faces[] = { 0, upper, upperNext, upper, lower, upperNext, upperNext, lower, lowerNext, 11, lowerNext, lower };
+		triangles.insert(triangles.end(), faces, faces + 12);
+	}
+
+	for (int step = 0; step < subdivisions; step++)
+	{
+		std::map<std::pair<int, int>, int> cache;
+		std::vector<int> subdivided;
+		for (int j = 0; j < (int)triangles.size(); j += 3)
+		{
+			int a = triangles[j];
+			int b = triangles[j + 1];
+			int c = triangles[j + 2];
+			int ab = midpoint(cache, vertices, a, b);
+			int bc = midpoint(cache, vertices, b, c);
+			int ca = midpoint(cache, vertices, c, a);
+			int faces[] = { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca };
+			subdivided.insert(subdivided.end(), faces, faces + 12);
+		}
+		triangles = subdivided;
+	}
+
+	IcosphereMesh mesh;
+	mesh.weldedVertexCount = vertices.size();
+	std::vector<glm::vec2> uvs;
+	for (const glm::vec3& vertex : vertices)
+	{
+		// same mapping as the UV sphere: u follows phi, v runs from 1 at the north pole to 0 at the south pole
+		float u = atan2(vertex.y, vertex.x) / (2 * icospherePi);
+		if (u < 0.0f)
+		{
+			u += 1.0f;
+		}
+		float v = 1.0f - acos(std::max(-1.0f, std::min(vertex.z, 1.0f))) / icospherePi;
+		uvs.push_back(glm::vec2(u, v));
+	}
+
+	// triangles across the seam would interpolate u backwards over the whole texture,
+	// their vertices near u = 0 get a copy at u + 1 instead. The poles (0 and 11) have no
+	// meaningful u and are left to the next step.
+	std::map<int, int> seamCopies;
+	for (int j = 0; j < (int)triangles.size(); j += 3)
+	{
+		float lowest = 1.0f;
+		float highest = 0.0f;
+		for (int corner = 0; corner < 3; corner++)
+		{
+			if (triangles[j + corner] == 0 || triangles[j + corner] == 11)
+			{
+				continue;
+			}
+			lowest = std::min(lowest, uvs[triangles[j + corner]].x);
+			highest = std::max(highest, uvs[triangles[j + corner]].x);
+		}
+		if (highest - lowest <= 0.5f)
+		{
+			continue;
+		}
+		for (int corner = 0; corner < 3; corner++)
+		{
+			int index = triangles[j + corner];
+			if (uvs[index].x >= 0.5f || index == 0 || index == 11)
+			{
+				continue;
+			}
+			if (seamCopies.find(index) == seamCopies.end())
+			{
+				vertices.push_back(vertices[index]);
+				uvs.push_back(glm::vec2(uvs[index].x + 1.0f, uvs[index].y));
+				seamCopies[index] = vertices.size() - 1;
+			}
+			triangles[j + corner] = seamCopies[index];
+		}
+	}
+
+	// u is undefined at the poles, every pole triangle gets its own pole vertex between the other two
+	for (int j = 0; j < (int)triangles.size(); j += 3)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			int index = triangles[j + corner];
+			if (index != 0 && index != 11)
+			{
+				continue;
+			}
+			int other1 = triangles[j + (corner + 1) % 3];
+			int other2 = triangles[j + (corner + 2) % 3];
+			vertices.push_back(vertices[index]);
+			uvs.push_back(glm::vec2(0.5f * (uvs[other1].x + uvs[other2].x), uvs[index].y));
+			triangles[j + corner] = vertices.size() - 1;
+		}
+	}
+
+	for (int j = 0; j < (int)vertices.size(); j++)
+	{
+		mesh.positions.push_back(vertices[j].x);
+		mesh.positions.push_back(vertices[j].y);
+		mesh.positions.push_back(vertices[j].z);
+		mesh.texCoords.push_back(uvs[j].x);
+		mesh.texCoords.push_back(uvs[j].y);
+	}
+	mesh.indices = triangles;
+	return mesh;
+}
+
+std::vector<float> placeIcosphere(const IcosphereMesh& mesh, float sphereRadius, glm::vec3 center, float rotation)
+{
+	std::vector<float> positions(mesh.positions.size());
+	fillPlacedIcosphere(positions, mesh, sphereRadius, center, rotation);
+	return positions;
+}
+
+void fillPlacedIcosphere(Span<float> positions, const IcosphereMesh& mesh, float sphereRadius, glm::vec3 center, float rotation)
+{
+	float cosRotation = cos(rotation);
+	float sinRotation = sin(rotation);
+	for (int j = 0; j < (int)mesh.positions.size(); j += 3)
+	{
+		float x = mesh.positions[j];
+		float y = mesh.positions[j + 1];
+		positions[j] = sphereRadius * (cosRotation * x - sinRotation * y) + center.x;
+		positions[j + 1] = sphereRadius * (sinRotation * x + cosRotation * y) + center.y;
+		positions[j + 2] = sphereRadius * mesh.positions[j + 2] + center.z;
+	}
+}
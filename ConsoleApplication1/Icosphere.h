@@ -0,0 +1,29 @@
+#ifndef ICOSPHERE_H
+#define ICOSPHERE_H
+
+#include <glm/glm.hpp>
+
+#include "Span.h"
+
+#include <vector>
+
+// Unit sphere from a subdivided icosahedron with poles on the z axis, like the UV spheres.
+// Edge midpoints are shared through a cache, so neighbouring triangles reuse the same vertex.
+// Only vertices on the texture seam (u = 0 / 1) and at the poles get copies with their own UVs.
+struct IcosphereMesh
+{
+	std::vector<float> positions;  // vec3 on the unit sphere, also the normals
+	std::vector<float> texCoords;  // vec2, mapped like GenerateSphereTexCoordinates
+	std::vector<int> indices;      // counter-clockwise seen from outside
+	int weldedVertexCount;         // vertices before the seam and pole copies
+};
+
+// subdivisions 0 = icosahedron, every step quadruples the triangles
+IcosphereMesh createIcosphere(int subdivisions);
+
+// scaled, rotated around z like RotateEarth and moved to center, as vec3 floats
+std::vector<float> placeIcosphere(const IcosphereMesh& mesh, float sphereRadius, glm::vec3 center, float rotation);
+// the same into positions, which has room for mesh.positions.size() floats
+void fillPlacedIcosphere(Span<float> positions, const IcosphereMesh& mesh, float sphereRadius, glm::vec3 center, float rotation);
+
+#endif //ICOSPHERE_H
@@ -0,0 +1,127 @@
+#include "IndexBuffer.h"
+
+#include <string.h>
+#include <utility>
+
+GLenum smallestIndexType(int vertexCount)
+{
+	return vertexCount <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+int indexSize(GLenum type)
+{
+	return type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+PackedIndices packIndices(GLenum mode, const std::vector<int>& indices, int vertexCount)
+{
+	PackedIndices packed;
+	packed.mode = mode;
+	packed.type = smallestIndexType(vertexCount);
+	packed.count = indices.size();
+	packed.bytes.resize(indexSize(packed.type) * indices.size());
+
+	for (int j = 0; j < (int)indices.size(); j++)
+	{
+		if (packed.type == GL_UNSIGNED_SHORT)
+		{
+			GLushort index = indices[j] == stripRestart ? 0xFFFF : (GLushort)indices[j];
+			memcpy(&packed.bytes[j * sizeof(index)], &index, sizeof(index));
+		}
+		else
+		{
+			GLuint index = indices[j] == stripRestart ? 0xFFFFFFFF : (GLuint)indices[j];
+			memcpy(&packed.bytes[j * sizeof(index)], &index, sizeof(index));
+		}
+	}
+	return packed;
+}
+
+std::vector<int> gridTriangleStrips(int rows, int columns)
+{
+	std::vector<int> strips(gridStripLength(rows, columns));
+	fillGridTriangleStrips(strips, rows, columns);
+	return strips;
+}
+
+int gridStripLength(int rows, int columns)
+{
+	return rows * (columns + 1) * 2 + rows - 1;
+}
+
+int gridTriangleCount(int rows, int columns)
+{
+	return rows * columns * 2;
+}
+
+void fillGridTriangleStrips(Span<int> strips, int rows, int columns)
+{
+	int j = 0;
+	for (int row = 0; row < rows; row++)
+	{
+		if (row > 0)
+		{
+			strips[j++] = stripRestart;
+		}
+		for (int column = 0; column <= columns; column++)
+		{
+			strips[j++] = row * (columns + 1) + column;
+			strips[j++] = (row + 1) * (columns + 1) + column;
+		}
+	}
+}
+
+void fillGridTriangles(Span<int> triangles, int rows, int columns)
+{
+	int j = 0;
+	for (int row = 0; row < rows; row++)
+	{
+		for (int column = 0; column < columns; column++)
+		{
+			int top = row * (columns + 1) + column;
+			int bottom = top + columns + 1;
+			// the two triangles of a strip step, the second one wound the other way round
+			triangles[j++] = top;
+			triangles[j++] = bottom;
+			triangles[j++] = top + 1;
+			triangles[j++] = top + 1;
+			triangles[j++] = bottom;
+			triangles[j++] = bottom + 1;
+		}
+	}
+}
+
+std::vector<int> stripsToTriangles(const std::vector<int>& strips)
+{
+	std::vector<int> triangles;
+	int stripStart = 0;
+	for (int j = 0; j < (int)strips.size(); j++)
+	{
+		if (strips[j] == stripRestart)
+		{
+			stripStart = j + 1;
+			continue;
+		}
+		int corner = j - stripStart;
+		if (corner < 2)
+		{
+			continue;
+		}
+		int a = strips[j - 2];
+		int b = strips[j - 1];
+		int c = strips[j];
+		if (a == b || b == c || a == c)
+		{
+			continue;
+		}
+		// every second triangle of a strip is wound the other way round
+		if (corner % 2 == 1)
+		{
+			std::swap(a, b);
+		}
+		triangles.push_back(a);
+		triangles.push_back(b);
+		triangles.push_back(c);
+	}
+	return triangles;
+}
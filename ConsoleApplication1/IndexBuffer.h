@@ -0,0 +1,43 @@
+#ifndef INDEXBUFFER_H
+#define INDEXBUFFER_H
+
+#include <glad/glad.h>
+
+#include "Span.h"
+
+#include <vector>
+
+// marks the end of a strip in the int lists below, packIndices turns it into the
+// all-ones index GL_PRIMITIVE_RESTART_FIXED_INDEX looks for
+#define stripRestart -1
+
+// indices the way they go into a buffer, 16 bit whenever the mesh is small enough
+struct PackedIndices
+{
+	GLenum mode;    // GL_TRIANGLES or GL_TRIANGLE_STRIP
+	GLenum type;    // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	int count;
+	std::vector<GLubyte> bytes;
+};
+
+// 16 bit as long as every vertex index stays below the restart index 0xFFFF
+GLenum smallestIndexType(int vertexCount);
+int indexSize(GLenum type);
+
+PackedIndices packIndices(GLenum mode, const std::vector<int>& indices, int vertexCount);
+
+// one triangle strip per row of a (rows+1)*(columns+1) vertex grid like the sphere generators
+// in Mobius.cpp, same triangles and winding as their expanded lists
+std::vector<int> gridTriangleStrips(int rows, int columns);
+
+// the same grid written into caller storage, gridStripLength and gridTriangleCount * 3 ints.
+// The triangles are the ones stripsToTriangles makes of the strips, in the same order.
+int gridStripLength(int rows, int columns);
+int gridTriangleCount(int rows, int columns);
+void fillGridTriangleStrips(Span<int> strips, int rows, int columns);
+void fillGridTriangles(Span<int> triangles, int rows, int columns);
+
+// expands strips separated by stripRestart into a triangle list, degenerate triangles are dropped
+std::vector<int> stripsToTriangles(const std::vector<int>& strips);
+
+#endif //INDEXBUFFER_H
@@ -0,0 +1,73 @@
+#include "Lod.h"
+
+#include <math.h>
+
+static const float lodPi = 3.14159265358979323846f;
+
+// sagitta of a chord that spans "angle" on a circle of radius r
+static float chordError(float r, float angle)
+{
+	return r * (1.0f - cos(angle / 2.0f));
+}
+
+float sphereLodError(float sphereRadius, int sphereStacks, int sphereSlices)
+{
+	float stackAngle = lodPi / sphereStacks;
+	float sliceAngle = 2.0f * lodPi / sphereSlices;
+	return chordError(sphereRadius, stackAngle > sliceAngle ? stackAngle : sliceAngle);
+}
+
+void addLodLevel(LodChain& chain, int mesh, int rows, int columns, float error)
+{
+	LodLevel level = { mesh, rows, columns, error };
+	int j = 0;
+	while (j < (int)chain.levels.size() && chain.levels[j].error < error)
+	{
+		j++;
+	}
+	chain.levels.insert(chain.levels.begin() + j, level);
+}
+
+float lodPixelsPerUnit(const glm::mat4& projection, int viewportHeight)
+{
+	// projection[1][1] = 1 / tan(fovy / 2), half the viewport spans that many units at distance 1
+	return projection[1][1] * viewportHeight * 0.5f;
+}
+
+// coarsest level whose error stays below "budget" object units, the finest if none does
+static int coarsestWithin(const LodChain& chain, float budget)
+{
+	int level = 0;
+	for (int j = 1; j < (int)chain.levels.size(); j++)
+	{
+		if (chain.levels[j].error <= budget)
+		{
+			level = j;
+		}
+	}
+	return level;
+}
+
+int selectLod(LodChain& chain, glm::vec3 center, glm::vec3 eye, float pixelsPerUnit, float maxPixelError, float hysteresis)
+{
+	// the nearest point of the bounding sphere decides, inside it everything is at full detail
+	float distance = glm::length(center - eye) - chain.boundingRadius;
+	if (distance <= 0.0f)
+	{
+		chain.current = 0;
+		return chain.current;
+	}
+
+	float unitsPerPixel = distance / pixelsPerUnit;
+	int finest = coarsestWithin(chain, maxPixelError * unitsPerPixel);
+	int coarsest = coarsestWithin(chain, maxPixelError * (1.0f - hysteresis) * unitsPerPixel);
+	if (chain.current > finest)
+	{
+		chain.current = finest;
+	}
+	else if (chain.current < coarsest)
+	{
+		chain.current = coarsest;
+	}
+	return chain.current;
+}
@@ -0,0 +1,45 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Level of detail chains for the generated meshes. Every level knows how far its tessellation
+// is at most away from the true surface (in object units), the renderer projects that error to
+// pixels each frame and draws the coarsest level that stays below a pixel budget.
+struct LodLevel
+{
+	int mesh;     // arena mesh id
+	int rows;     // generator resolution, stacks or strip segments
+	int columns;  // slices, or vertices across the strip
+	float error;
+};
+
+struct LodChain
+{
+	std::vector<LodLevel> levels;  // finest first
+	float boundingRadius;
+	int current;
+};
+
+// chord error of a UV sphere, the larger of the two angular steps decides
+float sphereLodError(float sphereRadius, int sphereStacks, int sphereSlices);
+
+// levels can be added in any order, they are kept sorted finest first
+void addLodLevel(LodChain& chain, int mesh, int rows, int columns, float error);
+
+// pixels covered by one object unit at distance 1, from the projection matrix and viewport height
+float lodPixelsPerUnit(const glm::mat4& projection, int viewportHeight);
+
+// Picks the level for this frame and stores it in chain.current. A level is too coarse once its
+// projected error exceeds maxPixelError, and the chain only goes coarser again when that level
+// stays below maxPixelError * (1 - hysteresis), so an object at the boundary does not pop back and forth.
+int selectLod(LodChain& chain, glm::vec3 center, glm::vec3 eye, float pixelsPerUnit, float maxPixelError, float hysteresis);
+
+inline const LodLevel& currentLod(const LodChain& chain)
+{
+	return chain.levels[chain.current];
+}
+
+#endif //LOD_H
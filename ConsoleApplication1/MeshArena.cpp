@@ -0,0 +1,403 @@
+#include "MeshArena.h"
+
+#include <iostream>
+
+const GLchar* vertexPullingShaderSource =
+"#version 440 core\n"
+"struct MeshDescriptor"
+"{"
+"	uint firstIndex;"
+"	uint indexCount;"
+"	uint baseVertex;"
+"	uint vertexCount;"
+"	uint packedStride;"
+"	uint indexSize;"
+"	uint mode;"
+"};"
+""
+"layout(std430, binding = 4) readonly buffer Arena { uint arena[]; };"
+"layout(std430, binding = 5) readonly buffer Meshes { MeshDescriptor meshes[]; };"
+""
+"out vec4 fragmentColor;"
+"out vec2 TexCoord;"
+"out vec3 normal;"
+"out vec3 fragPos;"
+""
+"uniform mat4 view;"
+"uniform mat4 projection;"
+"uniform mat4 model;"
+""
+"uniform int meshId;"
+"uniform int colorShift;"
+"uniform uint positionRegion;"
+"uniform uint normalRegion;"
+"uniform uint colorRegion;"
+"uniform uint texCoordRegion;"
+"uniform uint indexRegion;"
+""
+"uint fetchIndex(MeshDescriptor mesh, uint i)"
+"{"
+"	uint index = mesh.firstIndex + i;"
+"	if (mesh.indexSize == 2u)"
+"	{"
+		// two 16 bit indices per word, little endian
+"		return (arena[indexRegion + index / 2u] >> (16u * (index & 1u))) & 0xFFFFu;"
+"	}"
+"	return arena[indexRegion + index];"
+"}"
+""
+"float fetch(uint region, uint i)"
+"{"
+"	return uintBitsToFloat(arena[region + i]);"
+"}"
+""
+"void main()"
+"{"
+"	MeshDescriptor mesh = meshes[meshId];"
+"	uint local = fetchIndex(mesh, uint(gl_VertexID));"
+"	uint v = mesh.baseVertex + local;"
+"	uint c = mesh.baseVertex + (local + uint(colorShift)) % mesh.vertexCount;"
+""
+"	vec3 position = vec3(fetch(positionRegion, v * 3u), fetch(positionRegion, v * 3u + 1u), fetch(positionRegion, v * 3u + 2u));"
+"	vec3 n = vec3(fetch(normalRegion, v * 3u), fetch(normalRegion, v * 3u + 1u), fetch(normalRegion, v * 3u + 2u));"
+"	vec4 worldPos = model * vec4(position, 1.0);"
+""
+"	fragmentColor = vec4(fetch(colorRegion, c * 4u), fetch(colorRegion, c * 4u + 1u), fetch(colorRegion, c * 4u + 2u), fetch(colorRegion, c * 4u + 3u));"
+"	TexCoord = vec2(fetch(texCoordRegion, v * 2u), fetch(texCoordRegion, v * 2u + 1u));"
+"	normal = mat3(model) * n;"
+"	fragPos = worldPos.xyz;"
+"	gl_Position = projection * view * worldPos;"
+"}";
+
+static const int attributeFloats[4] = { 3, 3, 4, 2 };
+// where the classic vertex shaders in Mobius.cpp expect each attribute
+static const GLuint attributeLocation[4] = { 0, 3, 1, 2 };
+
+// keeps every region usable with glBindBufferRange
+static GLintptr alignRegion(GLintptr offset)
+{
+	return (offset + 255) & ~(GLintptr)255;
+}
+
+MeshArena createMeshArena(int vertexCapacity, int indexCapacity, int packedCapacity)
+{
+	MeshArena arena;
+	arena.vertexCapacity = vertexCapacity;
+	arena.indexCapacity = indexCapacity;
+	arena.packedCapacity = packedCapacity;
+	arena.vertices = createGpuAllocator(vertexCapacity);
+	arena.indices = createGpuAllocator(sizeof(GLuint) * indexCapacity);
+	arena.packed = createGpuAllocator(packedCapacity);
+
+	GLintptr size = 0;
+	for (int attribute = 0; attribute < 4; attribute++)
+	{
+		arena.regionOffset[attribute] = size;
+		size = alignRegion(size + sizeof(float) * attributeFloats[attribute] * vertexCapacity);
+	}
+	arena.indexOffset = size;
+	size = alignRegion(size + sizeof(GLuint) * indexCapacity);
+	arena.packedOffset = size;
+	size += packedCapacity;
+
+	glGenBuffers(1, &arena.buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, arena.buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, NULL, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &arena.descriptorBuffer);
+
+	// one VAO for every mesh, glDrawElementsBaseVertex picks the mesh's vertices
+	glGenVertexArrays(1, &arena.vao);
+	glBindVertexArray(arena.vao);
+	glBindBuffer(GL_ARRAY_BUFFER, arena.buffer);
+	for (int attribute = 0; attribute < 4; attribute++)
+	{
+		glEnableVertexAttribArray(attributeLocation[attribute]);
+		glVertexAttribPointer(attributeLocation[attribute], attributeFloats[attribute], GL_FLOAT, GL_FALSE, 0, (void*)arena.regionOffset[attribute]);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.buffer);
+	glBindVertexArray(0);
+	return arena;
+}
+
+// defragments first if the free space is there but split over several holes
+static void makeRoom(MeshArena& arena, const GpuAllocator& allocator, int size, int indexBytes)
+{
+	if (largestFreeBlock(allocator) < size || largestFreeBlock(arena.indices) < indexBytes)
+	{
+		if (freeSpace(allocator) >= size && freeSpace(arena.indices) >= indexBytes)
+		{
+			defragmentMeshArena(arena);
+		}
+	}
+}
+
+// uploads the indices of a mesh whose ranges are allocated and gives it a descriptor slot
+static int storeMesh(MeshArena& arena, const MeshDescriptor& mesh, const PackedIndices& indices)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, arena.buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, arena.indexOffset + mesh.indexSize * mesh.firstIndex, indices.bytes.size(), &indices.bytes.front());
+
+	// reuse the slot of a removed mesh so the descriptor table does not grow with every reload
+	for (int id = 0; id < (int)arena.meshes.size(); id++)
+	{
+		if (arena.meshes[id].vertexCount == 0)
+		{
+			arena.meshes[id] = mesh;
+			return id;
+		}
+	}
+	arena.meshes.push_back(mesh);
+	return arena.meshes.size() - 1;
+}
+
+// a descriptor with no vertices marks a free slot, so empty meshes cannot be stored at all
+static bool isEmptyMesh(int vertexCount, const PackedIndices& indices)
+{
+	if (vertexCount > 0 && indices.count > 0)
+	{
+		return false;
+	}
+	std::cout << "ERROR::MESHARENA::EMPTY_MESH " << vertexCount << " vertices, " << indices.count << " indices" << std::endl;
+	return true;
+}
+
+int addMesh(MeshArena& arena, int vertexCount, const PackedIndices& indices)
+{
+	if (isEmptyMesh(vertexCount, indices))
+	{
+		return -1;
+	}
+	int size = indexSize(indices.type);
+	makeRoom(arena, arena.vertices, vertexCount, indices.bytes.size() + size - 1);
+
+	int baseVertex = allocateBlock(arena.vertices, vertexCount);
+	int indexBytes = allocateBlock(arena.indices, indices.bytes.size(), size);
+	if (baseVertex < 0 || indexBytes < 0)
+	{
+		freeBlock(arena.vertices, baseVertex);
+		freeBlock(arena.indices, indexBytes);
+		std::cout << "ERROR::MESHARENA::OUT_OF_MEMORY" << std::endl;
+		return -1;
+	}
+
+	MeshDescriptor mesh = { (GLuint)(indexBytes / size), (GLuint)indices.count, (GLuint)baseVertex, (GLuint)vertexCount, 0, (GLuint)size, indices.mode };
+	return storeMesh(arena, mesh, indices);
+}
+
+int addMesh(MeshArena& arena, int vertexCount, const std::vector<int>& indices)
+{
+	return addMesh(arena, vertexCount, packIndices(GL_TRIANGLES, indices, vertexCount));
+}
+
+int addPackedMesh(MeshArena& arena, GLsizei stride, int vertexCount, const void* vertices, const PackedIndices& indices)
+{
+	if (isEmptyMesh(vertexCount, indices))
+	{
+		return -1;
+	}
+	int size = indexSize(indices.type);
+	makeRoom(arena, arena.packed, stride * vertexCount + stride - 1, indices.bytes.size() + size - 1);
+
+	int offset = allocateBlock(arena.packed, stride * vertexCount, stride);
+	int indexBytes = allocateBlock(arena.indices, indices.bytes.size(), size);
+	if (offset < 0 || indexBytes < 0)
+	{
+		freeBlock(arena.packed, offset);
+		freeBlock(arena.indices, indexBytes);
+		std::cout << "ERROR::MESHARENA::OUT_OF_MEMORY" << std::endl;
+		return -1;
+	}
+
+	MeshDescriptor mesh = { (GLuint)(indexBytes / size), (GLuint)indices.count, (GLuint)(offset / stride), (GLuint)vertexCount, (GLuint)stride, (GLuint)size, indices.mode };
+	int id = storeMesh(arena, mesh, indices);
+	setPackedVertices(arena, id, vertices);
+	return id;
+}
+
+int addPackedMesh(MeshArena& arena, GLsizei stride, int vertexCount, const void* vertices, const std::vector<int>& indices)
+{
+	return addPackedMesh(arena, stride, vertexCount, vertices, packIndices(GL_TRIANGLES, indices, vertexCount));
+}
+
+void removeMesh(MeshArena& arena, int mesh)
+{
+	MeshDescriptor& descriptor = arena.meshes[mesh];
+	if (descriptor.vertexCount == 0)
+	{
+		return;
+	}
+	if (descriptor.packedStride != 0)
+	{
+		freeBlock(arena.packed, descriptor.baseVertex * descriptor.packedStride);
+	}
+	else
+	{
+		freeBlock(arena.vertices, descriptor.baseVertex);
+	}
+	freeBlock(arena.indices, descriptor.indexSize * descriptor.firstIndex);
+	descriptor.indexCount = 0;
+	descriptor.vertexCount = 0;
+}
+
+void setMeshAttribute(MeshArena& arena, int mesh, MeshAttribute attribute, const std::vector<float>& data)
+{
+	const MeshDescriptor& descriptor = arena.meshes[mesh];
+	GLsizeiptr size = sizeof(float) * attributeFloats[attribute] * descriptor.vertexCount;
+	if ((GLsizeiptr)(sizeof(float) * data.size()) < size)
+	{
+		size = sizeof(float) * data.size();
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, arena.buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, arena.regionOffset[attribute] + sizeof(float) * attributeFloats[attribute] * descriptor.baseVertex, size, &data.front());
+}
+
+Span<float> mapMeshAttribute(MeshArena& arena, int mesh, MeshAttribute attribute)
+{
+	const MeshDescriptor& descriptor = arena.meshes[mesh];
+	int floats = attributeFloats[attribute] * descriptor.vertexCount;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, arena.buffer);
+	void* mapped = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, arena.regionOffset[attribute] + sizeof(float) * attributeFloats[attribute] * descriptor.baseVertex, sizeof(float) * floats, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	if (mapped == nullptr)
+	{
+		return Span<float>();
+	}
+	return Span<float>((float*)mapped, floats);
+}
+
+void unmapMeshArena(MeshArena& arena)
+{
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, arena.buffer);
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+}
+
+void setPackedVertices(MeshArena& arena, int mesh, const void* vertices)
+{
+	const MeshDescriptor& descriptor = arena.meshes[mesh];
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, arena.buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, arena.packedOffset + descriptor.packedStride * descriptor.baseVertex, descriptor.packedStride * descriptor.vertexCount, vertices);
+}
+
+// copies the moved ranges of one region to their new place, from the arena into the scratch
+// buffer or from there back into the arena
+static void copyMoves(GLenum source, GLenum destination, const std::vector<GpuMove>& moves, GLintptr region, GLsizeiptr stride, bool toScratch)
+{
+	for (const GpuMove& move : moves)
+	{
+		GLintptr from = region + stride * (toScratch ? move.from : move.to);
+		glCopyBufferSubData(source, destination, from, region + stride * move.to, stride * move.size);
+	}
+}
+
+void defragmentMeshArena(MeshArena& arena)
+{
+	std::vector<GpuMove> vertexMoves = defragmentAllocator(arena.vertices);
+	std::vector<GpuMove> indexMoves = defragmentAllocator(arena.indices);
+	std::vector<GpuMove> packedMoves = defragmentAllocator(arena.packed);
+	if (vertexMoves.empty() && indexMoves.empty() && packedMoves.empty())
+	{
+		return;
+	}
+
+	// source and destination of a move may overlap, which glCopyBufferSubData does not allow
+	// inside one buffer, so everything goes through a scratch buffer and back
+	GLuint scratch;
+	glGenBuffers(1, &scratch);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+	glBufferData(GL_COPY_WRITE_BUFFER, arena.packedOffset + arena.packedCapacity, NULL, GL_STREAM_COPY);
+	glBindBuffer(GL_COPY_READ_BUFFER, arena.buffer);
+	for (int attribute = 0; attribute < 4; attribute++)
+	{
+		copyMoves(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, vertexMoves, arena.regionOffset[attribute], sizeof(float) * attributeFloats[attribute], true);
+	}
+	copyMoves(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, indexMoves, arena.indexOffset, 1, true);
+	copyMoves(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, packedMoves, arena.packedOffset, 1, true);
+
+	glBindBuffer(GL_COPY_READ_BUFFER, scratch);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, arena.buffer);
+	for (int attribute = 0; attribute < 4; attribute++)
+	{
+		copyMoves(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, vertexMoves, arena.regionOffset[attribute], sizeof(float) * attributeFloats[attribute], false);
+	}
+	copyMoves(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, indexMoves, arena.indexOffset, 1, false);
+	copyMoves(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, packedMoves, arena.packedOffset, 1, false);
+	glDeleteBuffers(1, &scratch);
+
+	// indices are relative to baseVertex, so only the descriptors change
+	for (MeshDescriptor& mesh : arena.meshes)
+	{
+		if (mesh.vertexCount == 0)
+		{
+			continue;
+		}
+		// packed offsets stay multiples of the stride, the allocator keeps the alignment
+		int stride = mesh.packedStride != 0 ? mesh.packedStride : 1;
+		const std::vector<GpuMove>& moves = mesh.packedStride != 0 ? packedMoves : vertexMoves;
+		for (const GpuMove& move : moves)
+		{
+			if (move.from == (int)mesh.baseVertex * stride)
+			{
+				mesh.baseVertex = move.to / stride;
+				break;
+			}
+		}
+		for (const GpuMove& move : indexMoves)
+		{
+			if (move.from == (int)(mesh.indexSize * mesh.firstIndex))
+			{
+				mesh.firstIndex = move.to / mesh.indexSize;
+				break;
+			}
+		}
+	}
+	uploadMeshDescriptors(arena);
+}
+
+void uploadMeshDescriptors(MeshArena& arena)
+{
+	if (arena.meshes.empty())
+	{
+		return;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, arena.descriptorBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(MeshDescriptor) * arena.meshes.size(), &arena.meshes.front(), GL_STATIC_DRAW);
+}
+
+void bindMeshArena(const MeshArena& arena)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, arena.buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, arena.descriptorBuffer);
+	glBindVertexArray(arena.vao);
+}
+
+void drawMesh(const MeshArena& arena, int mesh)
+{
+	const MeshDescriptor& descriptor = arena.meshes[mesh];
+	GLenum type = descriptor.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	glDrawElementsBaseVertex(descriptor.mode, descriptor.indexCount, type, (void*)(arena.indexOffset + descriptor.indexSize * descriptor.firstIndex), descriptor.baseVertex);
+}
+
+void drawMeshInstanced(const MeshArena& arena, int mesh, int instanceCount)
+{
+	const MeshDescriptor& descriptor = arena.meshes[mesh];
+	GLenum type = descriptor.indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	glDrawElementsInstancedBaseVertex(descriptor.mode, descriptor.indexCount, type, (void*)(arena.indexOffset + descriptor.indexSize * descriptor.firstIndex), instanceCount, descriptor.baseVertex);
+}
+
+void setMeshArenaRegions(unsigned int program, const MeshArena& arena)
+{
+	glUseProgram(program);
+	glUniform1ui(glGetUniformLocation(program, "positionRegion"), arena.regionOffset[ATTRIBUTE_POSITION] / sizeof(GLuint));
+	glUniform1ui(glGetUniformLocation(program, "normalRegion"), arena.regionOffset[ATTRIBUTE_NORMAL] / sizeof(GLuint));
+	glUniform1ui(glGetUniformLocation(program, "colorRegion"), arena.regionOffset[ATTRIBUTE_COLOR] / sizeof(GLuint));
+	glUniform1ui(glGetUniformLocation(program, "texCoordRegion"), arena.regionOffset[ATTRIBUTE_TEXCOORD] / sizeof(GLuint));
+	glUniform1ui(glGetUniformLocation(program, "indexRegion"), arena.indexOffset / sizeof(GLuint));
+}
+
+void drawPulledMesh(const MeshArena& arena, unsigned int program, int mesh)
+{
+	glUniform1i(glGetUniformLocation(program, "meshId"), mesh);
+	glDrawArrays(GL_TRIANGLES, 0, arena.meshes[mesh].indexCount);
+}
@@ -0,0 +1,102 @@
+#ifndef MESHARENA_H
+#define MESHARENA_H
+
+#include <glad/glad.h>
+
+#include "GpuAllocator.h"
+#include "IndexBuffer.h"
+#include "Span.h"
+
+#include <vector>
+
+// vertex shader that fetches everything from the arena by gl_VertexID, outputs the same
+// varyings as vertexTextureShaderSource so it links against every fragment shader in Mobius.cpp
+extern const GLchar* vertexPullingShaderSource;
+
+enum MeshAttribute
+{
+	ATTRIBUTE_POSITION = 0,
+	ATTRIBUTE_NORMAL = 1,
+	ATTRIBUTE_COLOR = 2,
+	ATTRIBUTE_TEXCOORD = 3
+};
+
+// matches the std430 struct in the pulling shader
+struct MeshDescriptor
+{
+	GLuint firstIndex;    // counted in the mesh's own index size
+	GLuint indexCount;
+	GLuint baseVertex;
+	GLuint vertexCount;
+	GLuint packedStride;  // 0 = vertices in the attribute regions, else bytes per interleaved vertex
+	GLuint indexSize;     // 2 or 4 bytes
+	GLuint mode;          // GL_TRIANGLES, or GL_TRIANGLE_STRIP with the all-ones restart index
+};
+
+// One buffer holds the geometry of every mesh. It is split into a region per attribute
+// (vec3 positions, vec3 normals, vec4 colors, vec2 texcoords) that share the vertex numbering,
+// followed by the index region. Indices are relative to the mesh's baseVertex and 16 or 32 bit
+// per mesh, the index region is allocated in bytes.
+// Vertex and index ranges come from a GpuAllocator each, so meshes can be removed again
+// and the holes they leave are reused or packed away by defragmentMeshArena.
+// Interleaved vertices (see VertexLayout.h) go into a separate packed region behind the
+// indices. Their ranges are aligned to the stride, so with the layout's VAO reading from
+// packedOffset every mesh of that layout is reached by baseVertex = byte offset / stride.
+struct MeshArena
+{
+	GLuint buffer;
+	GLuint descriptorBuffer;
+	GLuint vao;           // attribute locations 0 position, 1 color, 2 texcoord, 3 normal, indices from the arena
+	int vertexCapacity;
+	int indexCapacity;    // in 32 bit indices
+	GLintptr regionOffset[4];
+	GLintptr indexOffset;
+	GLintptr packedOffset;
+	int packedCapacity;   // bytes
+	GpuAllocator vertices;
+	GpuAllocator indices;
+	GpuAllocator packed;
+	std::vector<MeshDescriptor> meshes;  // removed meshes keep their slot with zero counts
+};
+
+MeshArena createMeshArena(int vertexCapacity, int indexCapacity, int packedCapacity = 0);
+
+// reserves room for the mesh and uploads its indices, returns the mesh id or -1 if the arena is full
+// or the mesh has no vertices or no indices; -1 is not a mesh the other functions take.
+// The int list version stores a triangle list with the smallest index type.
+int addMesh(MeshArena& arena, int vertexCount, const PackedIndices& indices);
+int addMesh(MeshArena& arena, int vertexCount, const std::vector<int>& indices);
+void removeMesh(MeshArena& arena, int mesh);
+void setMeshAttribute(MeshArena& arena, int mesh, MeshAttribute attribute, const std::vector<float>& data);
+
+// Maps the mesh's range of one attribute region for writing, so a fill function from
+// MeshGenerators.h can put its output straight into the arena. The old contents are discarded.
+// Only one range can be mapped at a time and nothing may draw from the arena until
+// unmapMeshArena. Returns an empty span if the driver refuses the mapping.
+Span<float> mapMeshAttribute(MeshArena& arena, int mesh, MeshAttribute attribute);
+void unmapMeshArena(MeshArena& arena);
+
+// interleaved meshes are drawn with drawMesh while the layout's VAO is bound, not with the arena VAO
+// and not by the pulling shader
+int addPackedMesh(MeshArena& arena, GLsizei stride, int vertexCount, const void* vertices, const PackedIndices& indices);
+int addPackedMesh(MeshArena& arena, GLsizei stride, int vertexCount, const void* vertices, const std::vector<int>& indices);
+void setPackedVertices(MeshArena& arena, int mesh, const void* vertices);
+
+// packs all meshes to the front of their regions, baseVertex and firstIndex change but mesh ids
+// and the buffer name stay the same. Uploads the descriptors again.
+void defragmentMeshArena(MeshArena& arena);
+
+// call after adding meshes, before drawing
+void uploadMeshDescriptors(MeshArena& arena);
+
+// binds the descriptor and arena storage buffers and the arena VAO, both draw paths work after it
+void bindMeshArena(const MeshArena& arena);
+void drawMesh(const MeshArena& arena, int mesh);
+// instanceCount copies of the mesh, the vertex shader tells them apart by gl_InstanceID
+void drawMeshInstanced(const MeshArena& arena, int mesh, int instanceCount);
+
+// the pulling shader reads triangle lists only, strips have to go through drawMesh
+void setMeshArenaRegions(unsigned int program, const MeshArena& arena);
+void drawPulledMesh(const MeshArena& arena, unsigned int program, int mesh);
+
+#endif //MESHARENA_H
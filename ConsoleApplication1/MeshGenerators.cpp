@@ -0,0 +1,267 @@
+#include "MeshGenerators.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <stdio.h>
+#include <vector>
+
+static const float generatorPi = 3.14159265358979323846f;
+
+// angles passed to sinCos at once, small enough for the stack
+static const int generatorBatch = 64;
+// vertices per task when a pool is set, below that the split costs more than it saves
+static const int generatorGrain = 16384;
+
+static ThreadPool* generatorPool = nullptr;
+
+void setGeneratorPool(ThreadPool* pool)
+{
+	generatorPool = pool;
+}
+
+void generatorFor(int count, int grain, const std::function<void(int begin, int end)>& body)
+{
+	if (generatorPool == nullptr)
+	{
+		body(0, count);
+		return;
+	}
+	parallelFor(*generatorPool, count, grain, body);
+}
+
+// rows per task so that each one writes about generatorGrain vertices
+static int rowGrain(int verticesPerRow)
+{
+	return std::max(1, generatorGrain / std::max(1, verticesPerRow));
+}
+
+int sphereVertexCount(int sphereStacks, int sphereSlices)
+{
+	return (sphereStacks + 1) * (sphereSlices + 1);
+}
+
+// stacks [firstStack, endStack) of the sphere. The sines and cosines are separable: one batch
+// per block of stacks and of slices covers a whole block of vertices, written out as xyz.
+static void fillSphereStacks(Span<float> positions, int firstStack, int endStack, int sphereStacks, int sphereSlices, double sphereRadius, glm::vec3 center, TrigAccuracy accuracy)
+{
+	float thetas[generatorBatch], sinTheta[generatorBatch], cosTheta[generatorBatch];
+	float phis[generatorBatch], sinPhi[generatorBatch], cosPhi[generatorBatch];
+	for (int blockStack = firstStack; blockStack < endStack; blockStack += generatorBatch)
+	{
+		int stackCount = std::min(generatorBatch, endStack - blockStack);
+		for (int k = 0; k < stackCount; k++)
+		{
+			thetas[k] = (blockStack + k) * generatorPi / sphereStacks;
+		}
+		sinCos(thetas, sinTheta, cosTheta, stackCount, accuracy);
+
+		for (int firstSlice = 0; firstSlice <= sphereSlices; firstSlice += generatorBatch)
+		{
+			int sliceCount = std::min(generatorBatch, sphereSlices + 1 - firstSlice);
+			for (int k = 0; k < sliceCount; k++)
+			{
+				phis[k] = (firstSlice + k) * 2 * generatorPi / sphereSlices;
+			}
+			sinCos(phis, sinPhi, cosPhi, sliceCount, accuracy);
+
+			for (int stack = 0; stack < stackCount; stack++)
+			{
+				float* vertex = positions.data + ((blockStack + stack) * (sphereSlices + 1) + firstSlice) * 3;
+				for (int slice = 0; slice < sliceCount; slice++)
+				{
+					*vertex++ = sphereRadius * cosPhi[slice] * sinTheta[stack] + center.x;
+					*vertex++ = sphereRadius * sinPhi[slice] * sinTheta[stack] + center.y;
+					*vertex++ = sphereRadius * cosTheta[stack] + center.z;
+				}
+			}
+		}
+	}
+}
+
+void fillSphereVertices(Span<float> positions, int sphereStacks, int sphereSlices, double sphereRadius, glm::vec3 center, TrigAccuracy accuracy)
+{
+	generatorFor(sphereStacks + 1, rowGrain(sphereSlices + 1), [&](int begin, int end)
+	{
+		fillSphereStacks(positions, begin, end, sphereStacks, sphereSlices, sphereRadius, center, accuracy);
+	});
+}
+
+void fillSphereTexCoords(Span<float> texCoords, int sphereStacks, int sphereSlices)
+{
+	generatorFor(sphereStacks + 1, rowGrain(sphereSlices + 1), [&](int begin, int end)
+	{
+		int j = begin * (sphereSlices + 1) * 2;
+		for (int stack = begin; stack < end; stack++)
+		{
+			for (int slice = 0; slice <= sphereSlices; slice++)
+			{
+				texCoords[j++] = (slice * 1.0f) / (sphereSlices * 1.0f);
+				texCoords[j++] = 1.0f - (stack * 1.0f) / (sphereStacks * 1.0f);
+			}
+		}
+	});
+}
+
+// normalizes vec3 [begin, end) of "from" into "to", the two may be the same
+static void normalizeRange(Span<float> to, Span<const float> from, int begin, int end)
+{
+	for (int vertex = begin; vertex < end; vertex++)
+	{
+		int j = vertex * 3;
+		glm::vec3 normal = glm::normalize(glm::vec3(from[j], from[j + 1], from[j + 2]));
+		to[j] = normal.x;
+		to[j + 1] = normal.y;
+		to[j + 2] = normal.z;
+	}
+}
+
+void fillRadialNormals(Span<float> normals, Span<const float> positions)
+{
+	generatorFor(positions.size / 3, generatorGrain, [&](int begin, int end)
+	{
+		normalizeRange(normals, positions, begin, end);
+	});
+}
+
+int mobiusVertexCount(double step)
+{
+	// counted the way the generator steps, a rounding ceil(2 pi / step) could be one off
+	int samples = 0;
+	while (samples * step < 2 * generatorPi)
+	{
+		samples++;
+	}
+	return samples * 2;
+}
+
+void fillMobiusVertices(Span<float> positions, double step, double width, TrigAccuracy accuracy)
+{
+	// every sample computes its own a, so any split of the samples gives the same strip
+	generatorFor(mobiusVertexCount(step) / 2, rowGrain(2), [&](int begin, int end)
+	{
+		float angles[generatorBatch], sinA[generatorBatch], cosA[generatorBatch];
+		float halfAngles[generatorBatch], sinHalf[generatorBatch], cosHalf[generatorBatch];
+		float* vertex = positions.data + begin * 6;
+		for (int first = begin; first < end; first += generatorBatch)
+		{
+			int count = std::min(generatorBatch, end - first);
+			for (int k = 0; k < count; k++)
+			{
+				double a = (first + k) * step;
+				angles[k] = (float)a;
+				halfAngles[k] = (float)(a / 2);
+			}
+			sinCos(angles, sinA, cosA, count, accuracy);
+			sinCos(halfAngles, sinHalf, cosHalf, count, accuracy);
+
+			for (int k = 0; k < count; k++)
+			{
+				double edges[2] = { -width, width };
+				for (double s : edges)
+				{
+					*vertex++ = cosA[k] * (1 + (s * cosHalf[k]));
+					*vertex++ = sinA[k] * (1 + (s * cosHalf[k]));
+					*vertex++ = s * sinHalf[k];
+				}
+			}
+		}
+	});
+}
+
+// one sin and cos per coordinate like the generators used to, the baseline of the report
+static void fillSpherePerVertex(Span<float> positions, int sphereStacks, int sphereSlices, double sphereRadius)
+{
+	int j = 0;
+	for (int stack = 0; stack <= sphereStacks; stack++)
+	{
+		for (int slice = 0; slice <= sphereSlices; slice++)
+		{
+			float theta = stack * generatorPi / sphereStacks;
+			float phi = slice * 2 * generatorPi / sphereSlices;
+			positions[j++] = sphereRadius * std::cos(phi) * std::sin(theta);
+			positions[j++] = sphereRadius * std::sin(phi) * std::sin(theta);
+			positions[j++] = sphereRadius * std::cos(theta);
+		}
+	}
+}
+
+template <typename Generate>
+static double milliseconds(Generate generate)
+{
+	int repeats = 10;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int repeat = 0; repeat < repeats; repeat++)
+	{
+		generate();
+	}
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / repeats;
+}
+
+void printGeneratorReport()
+{
+	const int reportStacks = 512;
+	const int reportSlices = 1024;
+	const double reportStep = 0.0001;
+	std::vector<float> sphere(sphereVertexCount(reportStacks, reportSlices) * 3);
+	std::vector<float> strip(mobiusVertexCount(reportStep) * 3);
+
+	char line[128];
+	snprintf(line, sizeof(line), "sphere %dx%d, strip %d samples, ms per mesh", reportStacks, reportSlices, (int)strip.size() / 6);
+	std::cout << line << std::endl;
+	double perVertex = milliseconds([&]() { fillSpherePerVertex(sphere, reportStacks, reportSlices, 1.0); });
+	snprintf(line, sizeof(line), "%-19s  sphere %7.3f", "per vertex std::sin", perVertex);
+	std::cout << line << std::endl;
+
+	TrigBackend active = currentTrigBackend();
+	TrigBackend backends[] = { TRIG_SCALAR, TRIG_SSE2, TRIG_AVX2, TRIG_NEON };
+	for (TrigBackend backend : backends)
+	{
+		if (!trigBackendAvailable(backend))
+		{
+			continue;
+		}
+		setTrigBackend(backend);
+		double spherePrecise = milliseconds([&]() { fillSphereVertices(sphere, reportStacks, reportSlices, 1.0, glm::vec3(0.0f), TRIG_PRECISE); });
+		double stripPrecise = milliseconds([&]() { fillMobiusVertices(strip, reportStep, 0.5, TRIG_PRECISE); });
+		double stripFast = milliseconds([&]() { fillMobiusVertices(strip, reportStep, 0.5, TRIG_FAST); });
+		snprintf(line, sizeof(line), "%-19s  sphere %7.3f  strip %7.3f  strip fast %7.3f", trigBackendName(backend), spherePrecise, stripPrecise, stripFast);
+		std::cout << line << std::endl;
+	}
+	setTrigBackend(active);
+
+	// the same sphere and strip again, split over more and more threads
+	const int scalingStacks = 1024;
+	const int scalingSlices = 2048;
+	std::vector<float> bigSphere(sphereVertexCount(scalingStacks, scalingSlices) * 3);
+	std::vector<float> bigNormals(bigSphere.size());
+	ThreadPool* previous = generatorPool;
+	snprintf(line, sizeof(line), "sphere %dx%d with normals, strip %d samples, by threads", scalingStacks, scalingSlices, (int)strip.size() / 6);
+	std::cout << line << std::endl;
+	double single = 0.0;
+	int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	std::vector<int> threadCounts;
+	for (int threads = 1; threads < hardwareThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(hardwareThreads);
+	for (int threads : threadCounts)
+	{
+		ThreadPool* pool = createThreadPool(threads);
+		setGeneratorPool(pool);
+		double time = milliseconds([&]()
+		{
+			fillSphereVertices(bigSphere, scalingStacks, scalingSlices, 1.0, glm::vec3(0.0f));
+			fillRadialNormals(bigNormals, bigSphere);
+			fillMobiusVertices(strip, reportStep, 0.5);
+		});
+		single = threads == 1 ? time : single;
+		snprintf(line, sizeof(line), "%3d threads  %8.3f ms  speedup %5.2f", threads, time, single / time);
+		std::cout << line << std::endl;
+		setGeneratorPool(previous);
+		destroyThreadPool(pool);
+	}
+}
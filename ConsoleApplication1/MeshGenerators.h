@@ -0,0 +1,52 @@
+#ifndef MESHGENERATORS_H
+#define MESHGENERATORS_H
+
+#include <glm/glm.hpp>
+
+#include <functional>
+
+#include "SimdTrig.h"
+#include "Span.h"
+#include "ThreadPool.h"
+
+// The CPU generators in two steps: the count functions give the exact number of vertices, the
+// caller provides storage for them (a vector sized once, a static table, a range of the mesh
+// arena mapped with mapMeshAttribute) and the fill functions write into it without allocating.
+// Every fill writes exactly count * components floats and expects that much room.
+// The index lists of the sphere grid are in IndexBuffer.h, gridTriangleCount and fillGridTriangles.
+
+// With a pool set, the fills split their rows (stacks, strip samples, vertices) over it.
+// Every task writes its own rows, so the output is the same with any number of threads.
+// nullptr, the default, keeps everything on the calling thread.
+void setGeneratorPool(ThreadPool* pool);
+// body(begin, end) over [0, count) in chunks of "grain" on that pool, or in one call right here
+// when there is no pool or count fits in one chunk. For other mesh passes that split the same way.
+void generatorFor(int count, int grain, const std::function<void(int begin, int end)>& body);
+// Lambdas go in by reference: converted to std::function directly, a closure with more than a
+// couple of captures would be copied to the heap on every call.
+template <typename Body>
+void generatorFor(int count, int grain, const Body& body)
+{
+	generatorFor(count, grain, std::function<void(int begin, int end)>(std::cref(body)));
+}
+
+// UV sphere with poles on the z axis, (stacks + 1) * (slices + 1) vertices stack by stack
+int sphereVertexCount(int sphereStacks, int sphereSlices);
+// vec3 positions. The radius stays a double so the #defined radii round like calculateSphereVertices.
+// Sines and cosines come from the batched kernels in SimdTrig.h, once per stack and per slice.
+void fillSphereVertices(Span<float> positions, int sphereStacks, int sphereSlices, double sphereRadius, glm::vec3 center, TrigAccuracy accuracy = TRIG_PRECISE);
+// vec2, u around the sphere and v from 1 at the north pole to 0 at the south pole
+void fillSphereTexCoords(Span<float> texCoords, int sphereStacks, int sphereSlices);
+
+// direction from the origin to every position, the normals of a sphere around the origin
+void fillRadialNormals(Span<float> normals, Span<const float> positions);
+
+// Möbius strip in "step" increments while a < 2 pi, inner and outer edge per sample
+int mobiusVertexCount(double step);
+void fillMobiusVertices(Span<float> positions, double step, double width, TrigAccuracy accuracy = TRIG_PRECISE);
+
+// time of the sphere and strip fills with every available trig backend, against per vertex
+// std::sin, and how a large sphere scales with the number of threads
+void printGeneratorReport();
+
+#endif //MESHGENERATORS_H
@@ -0,0 +1,235 @@
+#include "MeshNormals.h"
+
+#include "MeshGenerators.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#include <utility>
+
+// triangles or vertices per task on the generator pool
+static const int normalGrain = 16384;
+
+static glm::vec3 vertexPosition(Span<const float> positions, int vertex)
+{
+	return glm::vec3(positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2]);
+}
+
+// 21 bits per axis, neighbouring cells that wrap into the same key are sorted out by the distance test
+static uint64_t cellKey(int64_t x, int64_t y, int64_t z)
+{
+	const int64_t mask = (1 << 21) - 1;
+	return (uint64_t)((x + (1 << 20)) & mask) << 42 | (uint64_t)((y + (1 << 20)) & mask) << 21 | (uint64_t)((z + (1 << 20)) & mask);
+}
+
+// other vertices within weldDistance, found through a grid of weldDistance sized cells sorted by key
+static void weldVertices(VertexAdjacency& adjacency, Span<const float> positions, float weldDistance)
+{
+	int vertexCount = adjacency.vertexCount;
+	float cell = weldDistance > 0.0f ? weldDistance : 1e-6f;
+	std::vector<std::pair<uint64_t, int>> cells(vertexCount);
+	std::vector<int64_t> coordinates(vertexCount * 3);
+	for (int vertex = 0; vertex < vertexCount; vertex++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			coordinates[vertex * 3 + axis] = (int64_t)std::floor(positions[vertex * 3 + axis] / cell);
+		}
+		cells[vertex] = std::make_pair(cellKey(coordinates[vertex * 3], coordinates[vertex * 3 + 1], coordinates[vertex * 3 + 2]), vertex);
+	}
+	std::sort(cells.begin(), cells.end());
+
+	adjacency.weldOffsets.assign(vertexCount + 1, 0);
+	adjacency.welded.clear();
+	for (int vertex = 0; vertex < vertexCount; vertex++)
+	{
+		int firstSibling = (int)adjacency.welded.size();
+		glm::vec3 position = vertexPosition(positions, vertex);
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dz = -1; dz <= 1; dz++)
+				{
+					uint64_t key = cellKey(coordinates[vertex * 3] + dx, coordinates[vertex * 3 + 1] + dy, coordinates[vertex * 3 + 2] + dz);
+					auto candidate = std::lower_bound(cells.begin(), cells.end(), std::make_pair(key, 0));
+					for (; candidate != cells.end() && candidate->first == key; ++candidate)
+					{
+						int other = candidate->second;
+						glm::vec3 offset = vertexPosition(positions, other) - position;
+						if (other != vertex && glm::dot(offset, offset) <= weldDistance * weldDistance)
+						{
+							adjacency.welded.push_back(other);
+						}
+					}
+				}
+			}
+		}
+		// a wrapped key can list a cell twice, and ascending order keeps the sums reproducible
+		std::sort(adjacency.welded.begin() + firstSibling, adjacency.welded.end());
+		adjacency.welded.erase(std::unique(adjacency.welded.begin() + firstSibling, adjacency.welded.end()), adjacency.welded.end());
+		adjacency.weldOffsets[vertex + 1] = (int)adjacency.welded.size();
+	}
+}
+
+VertexAdjacency buildVertexAdjacency(int vertexCount, Span<const int> indices, Span<const float> positions, float weldDistance)
+{
+	VertexAdjacency adjacency;
+	adjacency.vertexCount = vertexCount;
+
+	// counting sort of the corners by vertex, corners of one vertex stay in triangle order
+	int cornerCount = indices.size / 3 * 3;
+	adjacency.offsets.assign(vertexCount + 1, 0);
+	for (int corner = 0; corner < cornerCount; corner++)
+	{
+		adjacency.offsets[indices[corner] + 1]++;
+	}
+	for (int vertex = 0; vertex < vertexCount; vertex++)
+	{
+		adjacency.offsets[vertex + 1] += adjacency.offsets[vertex];
+	}
+	adjacency.corners.resize(cornerCount);
+	std::vector<int> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	for (int corner = 0; corner < cornerCount; corner++)
+	{
+		adjacency.corners[next[indices[corner]]++] = corner;
+	}
+
+	if (weldDistance >= 0.0f)
+	{
+		weldVertices(adjacency, positions, weldDistance);
+	}
+	else
+	{
+		adjacency.weldOffsets.assign(vertexCount + 1, 0);
+		adjacency.welded.clear();
+	}
+	return adjacency;
+}
+
+// sum of the weighted triangle normals around one vertex
+static glm::vec3 gatherVertex(const VertexAdjacency& adjacency, const std::vector<glm::vec3>& cornerNormals, int vertex, bool alignFaces)
+{
+	int first = adjacency.offsets[vertex];
+	int end = adjacency.offsets[vertex + 1];
+	// the side most of the weight is on: the plain sum, or the largest triangle if that cancels out
+	glm::vec3 reference = glm::vec3(0.0f);
+	if (alignFaces)
+	{
+		for (int j = first; j < end; j++)
+		{
+			reference += cornerNormals[adjacency.corners[j]];
+		}
+		if (glm::dot(reference, reference) == 0.0f)
+		{
+			for (int j = first; j < end; j++)
+			{
+				glm::vec3 normal = cornerNormals[adjacency.corners[j]];
+				if (glm::dot(normal, normal) > glm::dot(reference, reference))
+				{
+					reference = normal;
+				}
+			}
+		}
+	}
+	glm::vec3 sum = glm::vec3(0.0f);
+	for (int j = first; j < end; j++)
+	{
+		glm::vec3 normal = cornerNormals[adjacency.corners[j]];
+		sum += alignFaces && glm::dot(normal, reference) < 0.0f ? -normal : normal;
+	}
+	return sum;
+}
+
+void computeVertexNormals(Span<float> normals, Span<const float> positions, Span<const int> indices, const VertexAdjacency& adjacency, NormalWeighting weighting, bool alignFaces)
+{
+	// the weighted triangle normal as every corner sees it, computed once per triangle
+	int triangleCount = indices.size / 3;
+	std::vector<glm::vec3> cornerNormals(triangleCount * 3);
+	generatorFor(triangleCount, normalGrain, [&](int begin, int end)
+	{
+		for (int triangle = begin; triangle < end; triangle++)
+		{
+			glm::vec3 corners[3];
+			for (int corner = 0; corner < 3; corner++)
+			{
+				corners[corner] = vertexPosition(positions, indices[triangle * 3 + corner]);
+			}
+			// twice the area long
+			glm::vec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			float area = glm::length(normal);
+			// Triangles collapsed onto an edge or a point, like the pole copies of a UV sphere, have a
+			// direction made of rounding errors. Area weighting makes them vanish by itself, angle
+			// weighting would blow them up to full weight, so they are dropped when it is smaller
+			// than a millionth of the squared longest edge.
+			float longest = 0.0f;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				glm::vec3 edge = corners[(corner + 1) % 3] - corners[corner];
+				longest = std::max(longest, glm::dot(edge, edge));
+			}
+			bool collapsed = area <= 1e-6f * longest;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				float weight = 1.0f;
+				if (weighting == WEIGHT_ANGLE)
+				{
+					glm::vec3 toNext = corners[(corner + 1) % 3] - corners[corner];
+					glm::vec3 toLast = corners[(corner + 2) % 3] - corners[corner];
+					float lengths = glm::length(toNext) * glm::length(toLast);
+					weight = collapsed ? 0.0f : std::acos(std::max(-1.0f, std::min(1.0f, glm::dot(toNext, toLast) / lengths))) / area;
+				}
+				cornerNormals[triangle * 3 + corner] = normal * weight;
+			}
+		}
+	});
+
+	generatorFor(adjacency.vertexCount, normalGrain, [&](int begin, int end)
+	{
+		for (int vertex = begin; vertex < end; vertex++)
+		{
+			glm::vec3 own = gatherVertex(adjacency, cornerNormals, vertex, alignFaces);
+			glm::vec3 sum = own;
+			int firstSibling = adjacency.weldOffsets[vertex];
+			int endSibling = adjacency.weldOffsets[vertex + 1];
+			if (firstSibling != endSibling)
+			{
+				// the whole group in ascending order, so every copy adds up the same floats
+				int lowest = std::min(vertex, adjacency.welded[firstSibling]);
+				glm::vec3 reference = gatherVertex(adjacency, cornerNormals, lowest, alignFaces);
+				sum = glm::vec3(0.0f);
+				auto add = [&](glm::vec3 part)
+				{
+					sum += alignFaces && glm::dot(part, reference) < 0.0f ? -part : part;
+				};
+				bool selfAdded = false;
+				for (int j = firstSibling; j < endSibling; j++)
+				{
+					int member = adjacency.welded[j];
+					if (!selfAdded && vertex < member)
+					{
+						add(own);
+						selfAdded = true;
+					}
+					add(gatherVertex(adjacency, cornerNormals, member, alignFaces));
+				}
+				if (!selfAdded)
+				{
+					add(own);
+				}
+				// a copy on the other side of a one-sided seam keeps facing its own triangles
+				if (alignFaces && glm::dot(sum, own) < 0.0f)
+				{
+					sum = -sum;
+				}
+			}
+			float length = glm::length(sum);
+			glm::vec3 normal = length > 0.0f ? sum / length : glm::vec3(0.0f);
+			normals[vertex * 3] = normal.x;
+			normals[vertex * 3 + 1] = normal.y;
+			normals[vertex * 3 + 2] = normal.z;
+		}
+	});
+}
@@ -0,0 +1,43 @@
+#ifndef MESHNORMALS_H
+#define MESHNORMALS_H
+
+#include "Span.h"
+
+#include <vector>
+
+// Vertex normals for any indexed triangle list. Instead of scattering every triangle into its
+// three vertices, the vertex to triangle adjacency is built once as compressed rows and every
+// vertex gathers its own sum. No two vertices write the same memory, so the gather splits over
+// the generator pool (see MeshGenerators.h) and gives the same result for any thread count.
+// Normals follow the winding: counter-clockwise triangles seen from outside face outwards.
+
+enum NormalWeighting
+{
+	WEIGHT_AREA,   // larger triangles count more, the cheapest
+	WEIGHT_ANGLE   // by the triangle's angle at the vertex, independent of how a region is split up
+};
+
+// compressed rows: the corners of vertex v are corners[offsets[v]] .. corners[offsets[v + 1] - 1],
+// each one triangle * 3 + corner. welded lists the other vertices at the same place the same way.
+struct VertexAdjacency
+{
+	int vertexCount;
+	std::vector<int> offsets;
+	std::vector<int> corners;
+	std::vector<int> weldOffsets;
+	std::vector<int> welded;
+};
+
+// Vertices closer than weldDistance are welded: each one gathers the triangles of all of them,
+// so copies made for a texture seam or a hard cut get one shared normal. weldDistance < 0 welds
+// nothing and leaves positions unused.
+VertexAdjacency buildVertexAdjacency(int vertexCount, Span<const int> indices, Span<const float> positions, float weldDistance);
+
+// alignFaces flips the triangles around a vertex that face away from where most of their weight
+// points, and welded copies that face away from the vertex. Surfaces with one side only, like
+// the Möbius strip, cannot be wound consistently; without it the twist bends the normals where
+// the strip closes.
+// Vertices without triangles get a zero normal.
+void computeVertexNormals(Span<float> normals, Span<const float> positions, Span<const int> indices, const VertexAdjacency& adjacency, NormalWeighting weighting, bool alignFaces = false);
+
+#endif //MESHNORMALS_H
@@ -0,0 +1,233 @@
+#include "MeshOptimizer.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+// most current GPUs keep somewhere between 16 and 32 transformed vertices around
+static const int defaultCacheSize = 16;
+
+static int countVertices(const std::vector<int>& indices)
+{
+	int vertexCount = 0;
+	for (int index : indices)
+	{
+		vertexCount = std::max(vertexCount, index + 1);
+	}
+	return vertexCount;
+}
+
+float averageCacheMissRatio(const std::vector<int>& indices, int vertexCount, int cacheSize)
+{
+	if (indices.size() < 3)
+	{
+		return 0.0f;
+	}
+
+	// a vertex is in the cache if it was loaded less than cacheSize misses ago
+	std::vector<int> loadedAt(vertexCount, -cacheSize - 1);
+	int misses = 0;
+	for (int index : indices)
+	{
+		if (misses - loadedAt[index] > cacheSize)
+		{
+			loadedAt[index] = misses;
+			misses++;
+		}
+	}
+	return (float)misses / (indices.size() / 3);
+}
+
+std::vector<int> optimizeVertexCache(const std::vector<int>& indices, int vertexCount, int cacheSize, std::vector<int>* clusterStarts)
+{
+	int triangleCount = indices.size() / 3;
+
+	// triangles around every vertex, stored compressed row style
+	std::vector<int> liveTriangles(vertexCount, 0);
+	for (int index : indices)
+	{
+		liveTriangles[index]++;
+	}
+	std::vector<int> adjacencyStart(vertexCount + 1, 0);
+	for (int v = 0; v < vertexCount; v++)
+	{
+		adjacencyStart[v + 1] = adjacencyStart[v] + liveTriangles[v];
+	}
+	std::vector<int> adjacency(indices.size());
+	std::vector<int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+	for (int j = 0; j < (int)indices.size(); j++)
+	{
+		adjacency[fill[indices[j]]++] = j / 3;
+	}
+
+	std::vector<int> cacheTime(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<int> deadEnds;
+	std::vector<int> output;
+	output.reserve(indices.size());
+
+	int time = cacheSize + 1;
+	int cursor = 0;
+	int fanning = triangleCount > 0 ? indices[0] : -1;
+	bool newCluster = true;
+	while (fanning >= 0)
+	{
+		if (newCluster && clusterStarts)
+		{
+			clusterStarts->push_back(output.size());
+		}
+
+		// emit every remaining triangle around the fanning vertex
+		std::vector<int> candidates;
+		for (int j = adjacencyStart[fanning]; j < adjacencyStart[fanning + 1]; j++)
+		{
+			int triangle = adjacency[j];
+			if (emitted[triangle])
+			{
+				continue;
+			}
+			for (int corner = 0; corner < 3; corner++)
+			{
+				int v = indices[triangle * 3 + corner];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+				if (time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time;
+					time++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// next fanning vertex: the one that stays in the cache longest while still having work
+		int best = -1;
+		int bestPriority = -1;
+		for (int v : candidates)
+		{
+			if (liveTriangles[v] <= 0)
+			{
+				continue;
+			}
+			int priority = 0;
+			if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+			{
+				priority = time - cacheTime[v];
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = v;
+			}
+		}
+
+		// nothing in the cache to continue with, the next cluster starts cold
+		newCluster = best < 0;
+		while (best < 0 && !deadEnds.empty())
+		{
+			int v = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveTriangles[v] > 0)
+			{
+				best = v;
+			}
+		}
+		while (best < 0 && cursor < vertexCount)
+		{
+			if (liveTriangles[cursor] > 0)
+			{
+				best = cursor;
+			}
+			cursor++;
+		}
+		fanning = best;
+	}
+	return output;
+}
+
+std::vector<int> optimizeOverdraw(const std::vector<int>& indices, const std::vector<float>& positions, const std::vector<int>& clusterStarts)
+{
+	int clusterCount = clusterStarts.size();
+	if (clusterCount < 2)
+	{
+		return indices;
+	}
+
+	glm::vec3 meshCenter = glm::vec3(0.0f);
+	for (int j = 0; j < (int)positions.size(); j += 3)
+	{
+		meshCenter += glm::vec3(positions[j], positions[j + 1], positions[j + 2]);
+	}
+	meshCenter /= (float)(positions.size() / 3);
+
+	// area weighted center and normal of every cluster
+	std::vector<float> sortKey(clusterCount);
+	std::vector<int> order(clusterCount);
+	for (int cluster = 0; cluster < clusterCount; cluster++)
+	{
+		int begin = clusterStarts[cluster];
+		int end = cluster + 1 < clusterCount ? clusterStarts[cluster + 1] : indices.size();
+		glm::vec3 center = glm::vec3(0.0f);
+		glm::vec3 normal = glm::vec3(0.0f);
+		float area = 0.0f;
+		for (int j = begin; j < end; j += 3)
+		{
+			glm::vec3 a = glm::vec3(positions[indices[j] * 3], positions[indices[j] * 3 + 1], positions[indices[j] * 3 + 2]);
+			glm::vec3 b = glm::vec3(positions[indices[j + 1] * 3], positions[indices[j + 1] * 3 + 1], positions[indices[j + 1] * 3 + 2]);
+			glm::vec3 c = glm::vec3(positions[indices[j + 2] * 3], positions[indices[j + 2] * 3 + 1], positions[indices[j + 2] * 3 + 2]);
+			glm::vec3 faceNormal = glm::cross(b - a, c - a);
+			float faceArea = glm::length(faceNormal);
+			center += (a + b + c) / 3.0f * faceArea;
+			normal += faceNormal;
+			area += faceArea;
+		}
+		// the key compares directions only, an unnormalized normal would put big clusters first.
+		// Clusters without area or whose faces cancel out get no preference
+		float normalLength = glm::length(normal);
+		sortKey[cluster] = 0.0f;
+		if (area > 0.0f && normalLength > 0.0f)
+		{
+			center /= area;
+			sortKey[cluster] = glm::dot(center - meshCenter, normal / normalLength);
+		}
+		order[cluster] = cluster;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&sortKey](int a, int b) { return sortKey[a] > sortKey[b]; });
+
+	std::vector<int> output;
+	output.reserve(indices.size());
+	for (int cluster : order)
+	{
+		int begin = clusterStarts[cluster];
+		int end = cluster + 1 < clusterCount ? clusterStarts[cluster + 1] : indices.size();
+		output.insert(output.end(), indices.begin() + begin, indices.begin() + end);
+	}
+	return output;
+}
+
+std::vector<int> optimizeMesh(const std::vector<int>& indices, const std::vector<float>& positions)
+{
+	std::vector<int> clusterStarts;
+	std::vector<int> cacheOrder = optimizeVertexCache(indices, positions.size() / 3, defaultCacheSize, &clusterStarts);
+	return optimizeOverdraw(cacheOrder, positions, clusterStarts);
+}
+
+void printCacheReport(const char* name, const std::vector<int>& indices, const std::vector<float>& positions)
+{
+	int vertexCount = std::max((int)positions.size() / 3, countVertices(indices));
+	std::vector<int> optimized = optimizeMesh(indices, positions);
+
+	std::cout << name << ": " << indices.size() / 3 << " triangles, " << vertexCount << " vertices" << std::endl;
+	static const int cacheSizes[] = { 8, 16, 32 };
+	for (int cacheSize : cacheSizes)
+	{
+		std::cout << "  ACMR cache " << std::setw(2) << cacheSize << ": "
+			<< std::fixed << std::setprecision(3) << averageCacheMissRatio(indices, vertexCount, cacheSize)
+			<< " -> " << averageCacheMissRatio(optimized, vertexCount, cacheSize) << std::endl;
+	}
+}
@@ -0,0 +1,26 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <vector>
+
+// Reorders triangle lists for the post-transform vertex cache (Tipsify, Sander et al. 2007)
+// and then orders the resulting clusters so outward facing parts tend to be drawn first.
+// Triangles are only moved as a whole, their winding stays as it is.
+
+// average cache miss ratio: transformed vertices per triangle with a FIFO cache of cacheSize
+float averageCacheMissRatio(const std::vector<int>& indices, int vertexCount, int cacheSize);
+
+// clusterStarts receives the first index of every cluster, a new cluster begins wherever
+// the cache had nothing left to continue with
+std::vector<int> optimizeVertexCache(const std::vector<int>& indices, int vertexCount, int cacheSize, std::vector<int>* clusterStarts = 0);
+
+// sorts clusters by how far they face away from the mesh center, positions are vec3 floats
+std::vector<int> optimizeOverdraw(const std::vector<int>& indices, const std::vector<float>& positions, const std::vector<int>& clusterStarts);
+
+// both passes with the cache size the generated meshes are tuned for
+std::vector<int> optimizeMesh(const std::vector<int>& indices, const std::vector<float>& positions);
+
+// before/after table for one mesh at a few cache sizes
+void printCacheReport(const char* name, const std::vector<int>& indices, const std::vector<float>& positions);
+
+#endif //MESHOPTIMIZER_H
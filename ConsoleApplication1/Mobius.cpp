@@ -8,6 +8,30 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "AllocationTracker.h"
+#include "BakedMeshes.h"
+#include "ClusteredLights.h"
+#include "SphereImpostors.h"
+#include "ComputeMesher.h"
+#include "Icosphere.h"
+#include "IndexBuffer.h"
+#include "Lod.h"
+#include "MeshArena.h"
+#include "MeshGenerators.h"
+#include "MeshNormals.h"
+#include "MeshOptimizer.h"
+#include "MobiusTessellation.h"
+#include "NBody.h"
+#include "ParametricSurface.h"
+#include "Scene.h"
+#include "Shader.h"
+#include "SimdTrig.h"
+#include "SpscQueue.h"
+#include "StreamBuffer.h"
+#include "StripParticles.h"
+#include "ThreadPool.h"
+#include "VertexLayout.h"
+
 
 #include <iostream>
 #include <vector>
@@ -16,6 +40,7 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <thread>
 
 //Sphere Parameters
 #define radius 0.5
@@ -24,17 +49,148 @@
 #define kreisradius 2
 
 
+//Moon Parameters, it circles the earth's axis moonOrbitHeight in front of the strip
+#define radiusMoon 0.12
+#define moonOrbitRadius 0.7
+#define moonOrbitHeight 0.45
+
+
 //LightSphere Parameters
 #define radiusLight 0.2
 #define stacksLight 8 
 #define slicesLight 16
 
+//Mobius Parameters
+#define mobiusStep 0.2
+#define mobiusWidth 0.5
+
+//generate positions, normals and texcoords with compute shaders instead of the CPU generators
+#define computeMesher 1
+
+//evaluate strip and spheres in the vertex shader from one shared (u,v) grid
+#define parametricSurfaces 0
+#define parametricGridU 64
+#define parametricGridV 16
+
+//fetch all geometry from one buffer by gl_VertexID instead of per-mesh VAOs
+#define vertexPulling 0
+
+//size of the buffer every mesh is sub-allocated from
+#define meshArenaVertexCapacity 65536
+#define meshArenaIndexCapacity 262144
+#define meshArenaPackedCapacity (1 << 20)
+
+//draw strip and spheres from interleaved, quantized vertices packed on the CPU
+#define quantizedVertices 0
+#if quantizedVertices
+#undef computeMesher
+#define computeMesher 0
+#endif
+
+//reorder the generated triangle lists for the vertex cache and against overdraw.
+//The sphere strips of restartStrips keep their row order, a row reuses the row before it anyway
+#define optimizeIndices 1
+
+//draw the spheres as 16 bit triangle strips with GL_PRIMITIVE_RESTART_FIXED_INDEX
+#define restartStrips 1
+#if vertexPulling
+#undef restartStrips
+#define restartStrips 0 //the pulling shader reads triangle lists only
+#endif
+
+//earth and sun from a subdivided icosahedron instead of the UV spheres, generated on the CPU.
+//Subdivision 2 has about as many triangles as the UV earth, spread evenly instead of crowding the poles
+#define useIcosphere 0
+#define icosphereSubdivisions 2
+#if useIcosphere
+#undef computeMesher
+#define computeMesher 0
+#undef restartStrips
+#define restartStrips 0
+#endif
+
+//take the sphere vertices, normals, texcoords and indices from tables the compiler evaluates
+//for the parameters above instead of generating them at startup, see BakedMeshes.h
+#define bakedMeshes 1
+#if useIcosphere
+#undef bakedMeshes
+#define bakedMeshes 0
+#endif
+
+//sample the strip along a where it bends instead of in steps of mobiusStep, see MobiusTessellation.h
+#define adaptiveStrip 0
+#define mobiusTolerance 0.01f
+#if vertexPulling || parametricSurfaces
+#undef adaptiveStrip
+#define adaptiveStrip 0 //both shift the palette per vertex of the uniform strip
+#endif
+
+//draw strip, earth and sun from a chain of tessellations, the level is picked per frame
+//from the projected error, levels within lodHysteresis of the budget keep the previous choice
+#define lodChains 1
+#define lodMaxPixelError 1.0f
+#define lodHysteresis 0.25f
+#if !computeMesher || vertexPulling || parametricSurfaces
+#undef lodChains
+#define lodChains 0 //the levels are written by the compute meshers and drawn by the classic path
+#endif
+
+//sines and cosines of the CPU generators from the SSE2/AVX2/NEON kernels in SimdTrig.h,
+//0 keeps std::sin and std::cos
+#define simdTrig 1
+
+//split the CPU generators and the CPU jobs of every frame over a work-stealing pool, see ThreadPool.h.
+//0 = one thread per hardware thread, 1 = everything on the thread that asks for it
+#define generatorThreads 0
+
+//GL on a render thread of its own, fed one frame packet per frame through a lock-free queue,
+//while the main thread polls events and simulates the next frame. 0 does both one after the other.
+#define renderThread 1
+//frames the simulation may run ahead of the render thread
+#define frameQueueLength 2
+
+//light bodies circling the earth under their mutual gravity, stepped on the pool every frame and
+//drawn as instances of one coarse sphere, see NBody.h. 0 leaves them out
+#define orbitingBodies 4096
+#define nbodyBarnesHut 1 //octree instead of every pair, ahead from about a thousand bodies on
+#define nbodyTheta 0.5f
+#define nbodyTimeStep 0.01f
+#define bodyRadius 0.007f
+#if vertexPulling || parametricSurfaces
+#undef orbitingBodies
+#define orbitingBodies 0 //instanced through the arena VAO, which only the classic path binds
+#endif
+
+//particles flowing along the strip, kept as (a, s) on it and placed on the surface by a compute
+//shader every frame, see StripParticles.h. 0 leaves them out
+#define stripParticles (1 << 17)
+#define particleTimeStep 0.01f
+#define particleSize 0.004f
+#define particleLift 0.004f //above the surface, so the strip does not cover them
+
+//point lights besides the sun, binned into view-space clusters by a compute pass so every
+//fragment only loops over the few that reach it, see ClusteredLights.h. 0 = the sun alone
+#define pointLights 1024
+#define pointLightTimeStep 0.01f
+#define pointLightSphereRadius 0.012f
+
+//earth, moon, sun and the bodies as quads the fragment shader ray traces a sphere into, with
+//the hit's depth, instead of meshes, see SphereImpostors.h. 4 vertices per sphere at any quality
+#define sphereImpostors 0
+#if vertexPulling || parametricSurfaces
+#undef sphereImpostors
+#define sphereImpostors 0 //replaces the sphere draws of the classic path only
+#endif
+
+//frames before the allocation tracker (trackAllocations in AllocationTracker.h) expects no
+//more allocations, the first two animation steps still grow the frame arenas
+#define allocationWarmupFrames 130
 
 const GLchar* vertexShaderSource =
 "#version 440 core\n"
 "layout(location = 0) in vec3 aPos;"
 "layout(location = 1) in vec4 in_Color;"
-"layout(location = 2) in vec3 in_Normal;"
+"layout(location = 3) in vec3 in_Normal;"
 ""
 "out vec4 fragmentColor;"
 "out vec3 normal;"
@@ -75,6 +231,36 @@ const GLchar* vertexTextureShaderSource =
 "	fragPos = aPos;"
 "}";
 
+//vertexTextureShaderSource for many copies of one mesh around the origin, moved and scaled by
+//the vec4 (xyz position, w radius) of every instance
+const GLchar* vertexBodyShaderSource =
+"#version 440 core\n"
+"layout(location = 0) in vec3 aPos;"
+"layout(location = 1) in vec4 in_Color;"
+"layout(location = 2) in vec2 in_TexCoord;"
+"layout(location = 3) in vec3 in_Normal;"
+""
+"layout(std430, binding = 6) readonly buffer Instances { vec4 instances[]; };"
+""
+"out vec4 fragmentColor;"
+"out vec2 TexCoord;"
+"out vec3 normal;"
+"out vec3 fragPos;"
+""
+"uniform mat4 view;"
+"uniform mat4 projection;"
+""
+"void main()"
+"{"
+"	vec4 instance = instances[gl_InstanceID];"
+"	vec3 worldPos = instance.xyz + aPos * instance.w;"
+"	gl_Position = projection * view * vec4(worldPos, 1.0);"
+"   fragmentColor = in_Color;"
+"	TexCoord = in_TexCoord;"
+"	normal = in_Normal;"
+"	fragPos = worldPos;"
+"}";
+
 const GLchar* vertexLightShaderSource =
 "#version 440 core\n"
 "layout(location = 0) in vec3 aPos;"
@@ -94,20 +280,20 @@ const GLchar* vertexLightShaderSource =
 "	TexCoord = in_TexCoord;"
 "}";
 
+//one triangle over the whole screen on the far plane, no vertex buffer. Every corner carries the
+//direction it looks in, unprojected with the inverse of projection * rotation of the view; the
+//unprojection is linear in the screen position, so the interpolated direction is exact per pixel
 const GLchar* vertexSkyboxShaderSource =
 "#version 440 core\n"
-"layout(location = 0) in vec3 aPos;"
-""
 "out vec3 TexCoords;"
 ""
-"uniform mat4 projection;"
-"uniform mat4 view;"
+"uniform mat4 inverseViewProjection;"
 ""
 "void main()"
 "{"
-"TexCoords = aPos;"
-"vec4 pos = projection * view * vec4(aPos, 1.0);"
-"gl_Position = pos.xyww;"
+"vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;"
+"gl_Position = vec4(corner, 1.0, 1.0);"
+"TexCoords = (inverseViewProjection * gl_Position).xyz;"
 "}";
 
 const GLchar* fragmentShaderSource =
@@ -119,6 +305,9 @@ const GLchar* fragmentShaderSource =
 "in vec3 fragPos;"
 ""
 "uniform vec3 lightPos;"
+#if pointLights
+CLUSTERED_LIGHTING_GLSL
+#endif
 ""
 "void main()"
 "{"
@@ -129,6 +318,9 @@ const GLchar* fragmentShaderSource =
 "	float diff = max(dot(normal, lightDir), 0.0);"
 "	vec3 diffuse = vec3(diff,diff,diff);"
 "	vec3 totalLight = ambient + diffuse;"
+#if pointLights
+"	totalLight += clusteredLighting(fragPos, normalize(normal));"
+#endif
 ""
 "  out_color = vec4(totalLight, 1.0) * fragmentColor;"
 "}";
@@ -144,6 +336,9 @@ const GLchar* fragmentTextureShaderSource =
 ""
 "uniform sampler2D texture1;"
 "uniform vec3 lightPos;"
+#if pointLights
+CLUSTERED_LIGHTING_GLSL
+#endif
 ""
 "void main()"
 "{"
@@ -155,10 +350,70 @@ const GLchar* fragmentTextureShaderSource =
 "	float diff = max(dot(norm, lightDir), 0.0);"
 "	vec3 diffuse = vec3(diff,diff,diff);"
 "	vec3 totalLight = ambient + diffuse;"
+#if pointLights
+"	totalLight += clusteredLighting(fragPos, norm);"
+#endif
 ""
 "  out_color = vec4(totalLight, 1.0) * texture(texture1, TexCoord);\n"
 "}";
 
+#if sphereImpostors
+//fragmentTextureShaderSource for the ray traced spheres
+const GLchar* fragmentImpostorShaderSource =
+"#version 440 core\n"
+"out vec4 out_color;\n"
+""
+SPHERE_IMPOSTOR_GLSL
+""
+"uniform sampler2D texture1;"
+"uniform vec3 lightPos;"
+#if pointLights
+CLUSTERED_LIGHTING_GLSL
+#endif
+""
+"void main()"
+"{"
+"	vec3 fragPos;"
+"	vec3 norm;"
+"	vec2 texCoord;"
+"	bool hit = traceSphere(fragPos, norm, texCoord);"
+"	vec4 color = sampleSphere(texture1, texCoord);"
+"	if (!hit) discard;"
+""
+"	vec3 ambient = vec3(0.2, 0.2,0.2);"
+""
+"	vec3 lightDir = normalize(lightPos - fragPos);"
+"	float diff = max(dot(norm, lightDir), 0.0);"
+"	vec3 diffuse = vec3(diff,diff,diff);"
+"	vec3 totalLight = ambient + diffuse;"
+#if pointLights
+"	totalLight += clusteredLighting(fragPos, norm);"
+#endif
+""
+"  out_color = vec4(totalLight, 1.0) * color;\n"
+"}";
+
+//fragmentLightShaderSource for the ray traced spheres
+const GLchar* fragmentLightImpostorShaderSource =
+"#version 440 core\n"
+"out vec4 out_color;\n"
+""
+SPHERE_IMPOSTOR_GLSL
+""
+"uniform sampler2D texture1;"
+""
+"void main()"
+"{"
+"	vec3 fragPos;"
+"	vec3 norm;"
+"	vec2 texCoord;"
+"	bool hit = traceSphere(fragPos, norm, texCoord);"
+"	vec4 color = sampleSphere(texture1, texCoord);"
+"	if (!hit) discard;"
+"  out_color = color;\n"
+"}";
+#endif
+
 const GLchar* fragmentLightShaderSource =
 "#version 440 core\n"
 "out vec4 out_color;\n"
@@ -173,6 +428,37 @@ const GLchar* fragmentLightShaderSource =
 "  out_color = texture(texture1, TexCoord);\n"
 "}";
 
+//the point lights as small spheres in their own color, one instance per light
+const GLchar* vertexPointLightShaderSource =
+"#version 440 core\n"
+"layout(location = 0) in vec3 aPos;"
+""
+"layout(std430, binding = 10) readonly buffer Lights { vec4 lights[]; };"
+""
+"out vec4 fragmentColor;"
+""
+"uniform mat4 view;"
+"uniform mat4 projection;"
+"uniform float sphereRadius;"
+""
+"void main()"
+"{"
+"	vec3 center = lights[gl_InstanceID * 2].xyz;"
+"	gl_Position = projection * view * vec4(center + aPos * sphereRadius, 1.0);"
+"	fragmentColor = vec4(min(lights[gl_InstanceID * 2 + 1].rgb, vec3(1.0)), 1.0);"
+"}";
+
+const GLchar* fragmentPointLightShaderSource =
+"#version 440 core\n"
+"out vec4 out_color;\n"
+""
+"in vec4 fragmentColor;"
+""
+"void main()"
+"{"
+"  out_color = fragmentColor;\n"
+"}";
+
 const GLchar* fragmentSkyboxShaderSource =
 "#version 440 core\n"
 "out vec4 FragColor;"
@@ -201,28 +487,82 @@ float pitch = 0.0f;
 
 float deltaTime = 0.0f;	// time between current frame and last frame
 float lastFrame = 0.0f;
+int animationFrames = 0;	// frames since the strip colors, the earth and the sun last moved
 
 float pi = 3.14159265358979323846;
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+int stripSurfaceType = SURFACE_MOBIUS;
+
+//frames from one move of the strip colors, the earth and the sun to the next
+#define animationInterval 60
+
+//what the simulation hands the renderer for one frame, copied as a whole into the frame queue
+//so the render thread never reads the camera while processInput moves it
+struct FramePacket
+{
+	glm::mat4 view;
+	glm::vec3 cameraPos;
+	int stripSurfaceType;
+	bool animationStep;	// the strip colors, the earth and the sun move on this frame
+	int framebufferWidth;
+	int framebufferHeight;
+	bool quit;	// the last packet, the render thread stops there
+	int state;	// its FrameState
+	float earthRotation;
+	int sunPosition;	// index into the sun's circle
+	int animationSteps;	// so far, the strip palette moved by two colors with every one
+};
 
-void AdjustVertexData(int lightposition, std::vector<float> &LightSphereCenters, std::vector<float> &LightSphere);
-int main();
+//What the simulation leaves behind for one packet and is too large to copy into the queue.
+//A packet is being simulated, waits in the queue or is being rendered, so there is one state
+//for each packet that can be on its way at the same time.
+//The vertex data an animation step writes on the CPU is not in here: only the step's own frame
+//uploads it and the next step comes animationInterval frames later, when that packet is long done.
+#define frameStateCount (frameQueueLength + 2)
+static_assert(frameStateCount < animationInterval, "an animation step would overwrite vertex data an earlier packet still uploads");
+struct FrameState
+{
+	Scene scene;	// transforms, meshes and materials of the frame
+	std::vector<float> lights;	// lightFloats per point light
+	std::vector<float> bodyInstances;	// 4 floats per orbiting body
+};
+
+//16 bytes per strip and earth vertex instead of 40 and 32, 12 per sun vertex instead of 20
+typedef VertexLayout<PositionHalf, NormalPacked, ColorUnorm8> StripLayout;
+typedef VertexLayout<PositionHalf, NormalPacked, TexCoordUnorm16> EarthLayout;
+typedef VertexLayout<PositionHalf, TexCoordUnorm16> SunLayout;
+static_assert(StripLayout::stride == 16 && EarthLayout::stride == 16 && SunLayout::stride == 12, "vertex layouts are not tightly packed");
+
+#if bakedMeshes
+//both spheres around the origin, read-only data of the executable
+static constexpr BakedSphere<stacks, slices> bakedEarth = bakeSphere<stacks, slices>(radius);
+static constexpr BakedSphere<stacksLight, slicesLight> bakedLightSphere = bakeSphere<stacksLight, slicesLight>(radiusLight);
+#endif
+
+void AdjustVertexData(int lightposition, std::vector<float> &LightSphereCenters, Span<float> LightSphere);
+int main(int argc, char* argv[]);
+void printMeshReport();
 void RotateEarth(std::vector<float>&sphereVertices);
 
 
 
 void processInput(GLFWwindow *window);
+FramePacket readFrameInput(GLFWwindow *window);
 
-std::vector<float> calculateMobiusVertices(int rootOfVertices);
+std::vector<float> calculateMobiusVertices();
 std::vector<int> calculateMobiusIndices(int rootOfIndices);
 std::vector<float> calculateMobiusColors(int rootOfMobiusColors);
+std::vector<int> calculateMobiusLodIndices(int segments);
+std::vector<float> resampleMobiusColors(std::vector<float> &mobiusColors, const std::vector<float> &parameters, int rows);
+void fillResampledMobiusColors(Span<float> colors, const std::vector<float> &mobiusColors, Span<const float> parameters, int rows);
 
-std::vector<float> calculateSphereVertices(int rootOfSphereVertices);
-std::vector<int> calculateSphereIndices(int rootOfSphereIndices);
+std::vector<float> calculateSphereVertices();
+std::vector<int> calculateSphereIndices();
+PackedIndices calculateSphereLodIndices(int sphereStacks, int sphereSlices);
+void dispatchSphereLods(unsigned int program, MesherTarget &target, MeshArena &meshArena, LodChain &chain, float sphereRadius, glm::vec3 center, float rotation);
 
-std::vector<float> calculateLightSphereVertices(int rootOfSphereVertices);
-std::vector<int> calculateLightSphereIndices(int rootOfSphereIndices);
+std::vector<float> calculateLightSphereVertices();
+std::vector<int> calculateLightSphereIndices();
 std::vector<float> calculateLightSphereCenters(int rootOfMobiusColors);
 
 std::vector<float>GenerateSphereTexCoordinates();
@@ -232,8 +572,40 @@ std::vector<float> calculateEarthNormals(std::vector<float> &sphereVertices);
 
 unsigned int loadCubemap(std::vector<std::string> faces);
 
-int main()
+int main(int argc, char* argv[])
 {
+	if (argc > 1 && std::string(argv[1]) == "--acmr-report")
+	{
+		printMeshReport();
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--tessellation-report")
+	{
+		printTessellationReport(mobiusWidth);
+		return 0;
+	}
+#if !simdTrig
+	setTrigBackend(TRIG_SCALAR);
+#endif
+	if (argc > 1 && std::string(argv[1]) == "--trig-report")
+	{
+		printTrigReport();
+		printGeneratorReport();
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--scene-report")
+	{
+		ThreadPool* reportPool = createThreadPool(generatorThreads);
+		printSceneReport(*reportPool);
+		destroyThreadPool(reportPool);
+		return 0;
+	}
+	if (argc > 1 && std::string(argv[1]) == "--nbody-report")
+	{
+		printNBodyReport();
+		return 0;
+	}
+
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4); //initiate Opengl 4.4
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
@@ -258,175 +630,18 @@ int main()
 
 	glViewport(0, 0, screenWidth, screenHeight);
 
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-
 
 	//NON-TEXTURED SHADER
-	unsigned int vertexShader;
-	vertexShader = glCreateShader(GL_VERTEX_SHADER);
-
-	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
-	glCompileShader(vertexShader);
-
-	int  success;
-	char infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-
-	if (!success)
-	{
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	unsigned int fragmentShader;
-	fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
-	glCompileShader(fragmentShader);
-
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	unsigned int shaderProgram;
-	shaderProgram = glCreateProgram();
-
-	glAttachShader(shaderProgram, vertexShader);
-	glAttachShader(shaderProgram, fragmentShader);
-	glLinkProgram(shaderProgram);
-
-	glUseProgram(shaderProgram);
-
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-	glUseProgram(0);
+	unsigned int shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
 
 	//TEXTURED SHADER
-	unsigned int vertexTextureShader;
-	vertexTextureShader = glCreateShader(GL_VERTEX_SHADER);
-
-	glShaderSource(vertexTextureShader, 1, &vertexTextureShaderSource, NULL);
-	glCompileShader(vertexTextureShader);
-
-	glGetShaderiv(vertexTextureShader, GL_COMPILE_STATUS, &success);
-
-	if (!success)
-	{
-		glGetShaderInfoLog(vertexTextureShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	unsigned int fragmentTextureShader;
-	fragmentTextureShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentTextureShader, 1, &fragmentTextureShaderSource, NULL);
-	glCompileShader(fragmentTextureShader);
-
-	glGetShaderiv(fragmentTextureShader, GL_COMPILE_STATUS, &success);
-
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentTextureShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	unsigned int shaderTextureProgram;
-	shaderTextureProgram = glCreateProgram();
-
-	glAttachShader(shaderTextureProgram, vertexTextureShader);
-	glAttachShader(shaderTextureProgram, fragmentTextureShader);
-	glLinkProgram(shaderTextureProgram);
-
-
-	glDeleteShader(vertexTextureShader);
-	glDeleteShader(fragmentTextureShader);
-
-	glUseProgram(shaderTextureProgram);
+	unsigned int shaderTextureProgram = createShaderProgram(vertexTextureShaderSource, fragmentTextureShaderSource);
 
 	//LIGHT SHADER
-	unsigned int vertexLightShader;
-	vertexLightShader = glCreateShader(GL_VERTEX_SHADER);
-
-	glShaderSource(vertexLightShader, 1, &vertexLightShaderSource, NULL);
-	glCompileShader(vertexLightShader);
-
-	glGetShaderiv(vertexLightShader, GL_COMPILE_STATUS, &success);
-
-	if (!success)
-	{
-		glGetShaderInfoLog(vertexLightShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	unsigned int fragmentLightShader;
-	fragmentLightShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentLightShader, 1, &fragmentLightShaderSource, NULL);
-	glCompileShader(fragmentLightShader);
-
-	glGetShaderiv(fragmentLightShader, GL_COMPILE_STATUS, &success);
-
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentLightShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	unsigned int shaderLightProgram;
-	shaderLightProgram = glCreateProgram();
-
-	glAttachShader(shaderLightProgram, vertexLightShader);
-	glAttachShader(shaderLightProgram, fragmentLightShader);
-	glLinkProgram(shaderLightProgram);
-
-
-	glDeleteShader(vertexLightShader);
-	glDeleteShader(fragmentLightShader);
-
-	glUseProgram(shaderLightProgram);
+	unsigned int shaderLightProgram = createShaderProgram(vertexLightShaderSource, fragmentLightShaderSource);
 
 	//SKYBOX SHADER
-	unsigned int vertexSkyboxShader;
-	vertexSkyboxShader = glCreateShader(GL_VERTEX_SHADER);
-
-	glShaderSource(vertexSkyboxShader, 1, &vertexSkyboxShaderSource, NULL);
-	glCompileShader(vertexSkyboxShader);
-
-	glGetShaderiv(vertexSkyboxShader, GL_COMPILE_STATUS, &success);
-
-	if (!success)
-	{
-		glGetShaderInfoLog(vertexSkyboxShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	unsigned int fragmentSkyboxShader;
-	fragmentSkyboxShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentSkyboxShader, 1, &fragmentSkyboxShaderSource, NULL);
-	glCompileShader(fragmentSkyboxShader);
-
-	glGetShaderiv(fragmentSkyboxShader, GL_COMPILE_STATUS, &success);
-
-	if (!success)
-	{
-		glGetShaderInfoLog(fragmentSkyboxShader, 512, NULL, infoLog);
-		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-	}
-
-	unsigned int shaderSkyboxProgram;
-	shaderSkyboxProgram = glCreateProgram();
-
-	glAttachShader(shaderSkyboxProgram, vertexSkyboxShader);
-	glAttachShader(shaderSkyboxProgram, fragmentSkyboxShader);
-	glLinkProgram(shaderSkyboxProgram);
-
-
-	glDeleteShader(vertexSkyboxShader);
-	glDeleteShader(fragmentSkyboxShader);
-
-	glUseProgram(shaderSkyboxProgram);
+	unsigned int shaderSkyboxProgram = createShaderProgram(vertexSkyboxShaderSource, fragmentSkyboxShaderSource);
 
 	//SUN SHADER
 
@@ -443,163 +658,271 @@ int main()
 
 	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &proj[0][0]);
 
-	std::vector<float> mobiusVertices = calculateMobiusVertices(64 * 3);
+	//with generatorThreads 1 the pool has no workers and everything runs right where it is called
+	ThreadPool* threadPool = createThreadPool(generatorThreads);
+	setGeneratorPool(threadPool);
+
 	std::vector<int> mobiusIndices = calculateMobiusIndices(64 * 3);
 	std::vector<float> mobiusColors = calculateMobiusColors(192 * 4);
-
-
-	std::vector<float> sphereVertices = calculateSphereVertices(160 * 3);
-	std::vector<int> sphereIndices = calculateSphereIndices(272);
-
-	std::vector<float> LightSphereVertices = calculateLightSphereVertices(160 * 3);
-	std::vector<int> LightSphereIndices = calculateLightSphereIndices(272);
+#if adaptiveStrip
+	//the palette stays at 32 segments and is stretched over the adaptive samples
+	MobiusTessellation adaptiveMobius = tessellateMobiusAdaptive(mobiusWidth, mobiusTolerance);
+	mobiusIndices = adaptiveMobius.indices;
+	std::vector<float> stripColors = resampleMobiusColors(mobiusColors, adaptiveMobius.parameters, adaptiveMobius.rows);
+#else
+	std::vector<float> stripColors = mobiusColors;
+#endif
+
+#if bakedMeshes
+	std::vector<int> sphereIndices(bakedEarth.triangles.begin(), bakedEarth.triangles.end());
+#else
+	std::vector<int> sphereIndices = calculateSphereIndices();
+#endif
+
+#if bakedMeshes
+	std::vector<int> LightSphereIndices(bakedLightSphere.triangles.begin(), bakedLightSphere.triangles.end());
+#else
+	std::vector<int> LightSphereIndices = calculateLightSphereIndices();
+#endif
 	std::vector<float> LightSphereCenters = calculateLightSphereCenters(360 * 3);
-
+#if useIcosphere
+	IcosphereMesh icosphere = createIcosphere(icosphereSubdivisions);
+	sphereIndices = icosphere.indices;
+	LightSphereIndices = icosphere.indices;
+#endif
+
+#if optimizeIndices
+	//the optimizer only needs positions to order the clusters, the CPU generators are cheap enough for that
+#if adaptiveStrip
+	mobiusIndices = optimizeMesh(mobiusIndices, adaptiveMobius.positions);
+#else
+	mobiusIndices = optimizeMesh(mobiusIndices, calculateMobiusVertices());
+#endif
+#if restartStrips
+	//the spheres draw their row strips instead of these lists, see gridTriangleStrips
+#elif useIcosphere
+	sphereIndices = optimizeMesh(sphereIndices, icosphere.positions);
+	LightSphereIndices = sphereIndices;
+#elif bakedMeshes
+	sphereIndices = optimizeMesh(sphereIndices, std::vector<float>(bakedEarth.positions.begin(), bakedEarth.positions.end()));
+	LightSphereIndices = optimizeMesh(LightSphereIndices, std::vector<float>(bakedLightSphere.positions.begin(), bakedLightSphere.positions.end()));
+#else
+	sphereIndices = optimizeMesh(sphereIndices, calculateSphereVertices());
+	LightSphereIndices = optimizeMesh(LightSphereIndices, calculateLightSphereVertices());
+#endif
+#endif
+	float earthRotation = 0;
+
+#if computeMesher
+	//vertex data is written on the GPU once the buffers exist
+	unsigned int mobiusMesher = createMobiusMesher();
+	unsigned int sphereMesher = createSphereMesher();
+
+	int mobiusSegments = (int)ceil(2 * pi / mobiusStep);
+#if adaptiveStrip
+	int mobiusVertexCount = adaptiveMobius.positions.size() / 3;
+#else
+	int mobiusVertexCount = mobiusSegments * 2;
+#endif
+	int sphereVertexCount = (stacks + 1) * (slices + 1);
+	int LightSphereVertexCount = (stacksLight + 1) * (slicesLight + 1);
+#else
+#if adaptiveStrip
+	std::vector<float> mobiusVertices = adaptiveMobius.positions;
+#else
+	std::vector<float> mobiusVertices = calculateMobiusVertices();
+#endif
+#if useIcosphere
+	std::vector<float> sphereVertices = placeIcosphere(icosphere, radius, glm::vec3(0.0f), 0.0f);
+	std::vector<float> LightSphereVertices = placeIcosphere(icosphere, radiusLight, glm::vec3(kreisradius), 0.0f);
+#elif bakedMeshes
+	//copies, the CPU path rotates and moves them in place
+	std::vector<float> sphereVertices(bakedEarth.positions.begin(), bakedEarth.positions.end());
+	std::vector<float> LightSphereVertices(bakedLightSphere.positions.begin(), bakedLightSphere.positions.end());
+	for (float& coordinate : LightSphereVertices)
+	{
+		coordinate += kreisradius;
+	}
+#else
+	std::vector<float> sphereVertices = calculateSphereVertices();
+	std::vector<float> LightSphereVertices = calculateLightSphereVertices();
+#endif
+
+#if adaptiveStrip
+	std::vector<float> mobiusNormals = adaptiveMobius.normals;
+#else
 	std::vector<float> mobiusNormals = calculateMobiusNormals(mobiusIndices, mobiusVertices);
-	mobiusNormals[63 * 3] = mobiusNormals[62 * 3];
-	mobiusNormals[63 * 3 + 1] = mobiusNormals[62 * 3 + 1];
-	mobiusNormals[63 * 3 + 2] = mobiusNormals[62 * 3 + 2];
+#endif
+#if bakedMeshes
+	std::vector<float> earthNormals(bakedEarth.normals.begin(), bakedEarth.normals.end());
+#else
 	std::vector<float> earthNormals = calculateEarthNormals(sphereVertices);
+#endif
 
+	int mobiusVertexCount = mobiusVertices.size() / 3;
+	int sphereVertexCount = sphereVertices.size() / 3;
+	int LightSphereVertexCount = LightSphereVertices.size() / 3;
+#endif
 
-	// ids for mobius
-	GLuint  VAO;
-	GLuint  VBOnormals;
-	GLuint  EBO;
-	GLuint  VBOcoords;
 
 	glEnable(GL_DEPTH_TEST);          // activate Z-Buffer and DepthTest
 
-
-
-
-	// create mobius vertex array object
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-
-	// create coords object
-	glGenBuffers(1, &VBOcoords);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOcoords);
-	glBufferData(GL_ARRAY_BUFFER, 4 * mobiusVertices.size(), &mobiusVertices.front(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-	// create color buffer
-	GLuint colorbuffer;
-	glGenBuffers(1, &colorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, 6 * mobiusColors.size(), &mobiusColors.front(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-	//create normals
-	glGenBuffers(1, &VBOnormals);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOnormals);
-	glBufferData(GL_ARRAY_BUFFER, 4 * mobiusNormals.size(), &mobiusNormals.front(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-	// create buffer object for indices
-	glGenBuffers(1, &EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, 4 * mobiusIndices.size(), &mobiusIndices.front(), GL_STATIC_DRAW);
-
-	// ids for second mobius
-	GLuint  VAO_back;
-	GLuint  VBOnormals_back;
-	GLuint  EBO_back;
-	GLuint  VBOcoords_back;
-
-
-	// create mobius vertex array object
-	glGenVertexArrays(1, &VAO_back);
-	glBindVertexArray(VAO_back);
-
-	// create coords object
-	glGenBuffers(1, &VBOcoords_back);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOcoords_back);
-	glBufferData(GL_ARRAY_BUFFER, 4 * mobiusVertices.size(), &mobiusVertices.front(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-	// create color buffer
-	GLuint colorbuffer_back;
-	glGenBuffers(1, &colorbuffer_back);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer_back);
-	glBufferData(GL_ARRAY_BUFFER, 6 * mobiusColors.size(), &mobiusColors.front(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-	//create normals
-	std::vector<float> mobiusNormals_back;
-	mobiusNormals_back = mobiusNormals;	
-	for (int j = 0; j < mobiusNormals.size(); j++)
+	//every mesh is a range of one arena buffer and is drawn with glDrawElementsBaseVertex
+	MeshArena meshArena = createMeshArena(meshArenaVertexCapacity, meshArenaIndexCapacity, meshArenaPackedCapacity);
+	int mobiusMesh = addMesh(meshArena, mobiusVertexCount, mobiusIndices);
+#if restartStrips
+	//one strip per stack: 558 index bytes for the earth instead of 3240 as a 32 bit list
+	glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+#if bakedMeshes
+	PackedIndices earthIndices = packIndices(GL_TRIANGLE_STRIP, std::vector<int>(bakedEarth.strips.begin(), bakedEarth.strips.end()), sphereVertexCount);
+	PackedIndices sunIndices = packIndices(GL_TRIANGLE_STRIP, std::vector<int>(bakedLightSphere.strips.begin(), bakedLightSphere.strips.end()), LightSphereVertexCount);
+#else
+	PackedIndices earthIndices = packIndices(GL_TRIANGLE_STRIP, gridTriangleStrips(stacks, slices), sphereVertexCount);
+	PackedIndices sunIndices = packIndices(GL_TRIANGLE_STRIP, gridTriangleStrips(stacksLight, slicesLight), LightSphereVertexCount);
+#endif
+#else
+	PackedIndices earthIndices = packIndices(GL_TRIANGLES, sphereIndices, sphereVertexCount);
+	PackedIndices sunIndices = packIndices(GL_TRIANGLES, LightSphereIndices, LightSphereVertexCount);
+#endif
+	int earthMesh = addMesh(meshArena, sphereVertexCount, earthIndices);
+	int sunMesh = addMesh(meshArena, LightSphereVertexCount, sunIndices);
+#if computeMesher
+	//the sun's grid, the sphere mesher writes it at the moon's size
+	int moonMesh = addMesh(meshArena, LightSphereVertexCount, sunIndices);
+#else
+	//the earth's vertices scaled down and placed on the CPU
+	int moonMesh = addMesh(meshArena, sphereVertexCount, earthIndices);
+#endif
+
+	//what is drawn where: meshes, textures as materials and transforms. The moon is the earth's
+	//child and turns with it; the sun starts where its mesh is generated and then follows
+	//LightSphereCenters. Everything that draws them reads their place from here.
+	Scene scene;
+	int stripEntity = createEntity(scene, -1, mobiusMesh, 0, 1.0f + mobiusWidth);
+	int earthEntity = createEntity(scene, -1, earthMesh, 0, radius);
+	int moonEntity = createEntity(scene, earthEntity, moonMesh, 0, radiusMoon);
+	int sunEntity = createEntity(scene, -1, sunMesh, 0, radiusLight);
+	setLocalPosition(scene, moonEntity, glm::vec3(moonOrbitRadius, 0.0f, moonOrbitHeight));
+	setLocalPosition(scene, sunEntity, glm::vec3(kreisradius));
+	updateWorldTransforms(scene);
+#if vertexPulling
+	//drawn with the moon's world matrix as model, so its mesh stays around the origin
+	glm::vec3 moonMeshCenter = glm::vec3(0.0f);
+	float moonMeshRotation = 0.0f;
+#else
+	glm::vec3 moonMeshCenter = worldPosition(scene, moonEntity);
+	float moonMeshRotation = earthRotation;
+#endif
+
+	setMeshAttribute(meshArena, mobiusMesh, ATTRIBUTE_COLOR, stripColors);
+#if computeMesher
+	MesherTarget arenaTarget = { meshArena.buffer, meshArena.buffer, meshArena.buffer, 0, (GLuint)meshArena.regionOffset[ATTRIBUTE_POSITION], (GLuint)meshArena.regionOffset[ATTRIBUTE_NORMAL], (GLuint)meshArena.regionOffset[ATTRIBUTE_TEXCOORD] };
+	arenaTarget.baseVertex = meshArena.meshes[mobiusMesh].baseVertex;
+#if adaptiveStrip
+	//the mesher only steps uniformly, the adaptive samples come from the CPU
+	setMeshAttribute(meshArena, mobiusMesh, ATTRIBUTE_POSITION, adaptiveMobius.positions);
+	setMeshAttribute(meshArena, mobiusMesh, ATTRIBUTE_NORMAL, adaptiveMobius.normals);
+#else
+	dispatchMobiusMesher(mobiusMesher, arenaTarget, mobiusSegments, 2, mobiusStep, mobiusWidth);
+#endif
+	arenaTarget.baseVertex = meshArena.meshes[earthMesh].baseVertex;
+	dispatchSphereMesher(sphereMesher, arenaTarget, stacks, slices, radius, glm::vec3(0.0f), earthRotation);
+	arenaTarget.baseVertex = meshArena.meshes[sunMesh].baseVertex;
+	dispatchSphereMesher(sphereMesher, arenaTarget, stacksLight, slicesLight, radiusLight, glm::vec3(kreisradius), 0.0f);
+	arenaTarget.baseVertex = meshArena.meshes[moonMesh].baseVertex;
+	dispatchSphereMesher(sphereMesher, arenaTarget, stacksLight, slicesLight, radiusMoon, moonMeshCenter, moonMeshRotation);
+#if lodChains
+	//the meshes above are the middle level of every chain, the finer and coarser ones are added here
+	LodChain stripLod = { std::vector<LodLevel>(), 1.0f + mobiusWidth, 0 };
+	LodChain earthLod = { std::vector<LodLevel>(), radius, 0 };
+	LodChain sunLod = { std::vector<LodLevel>(), radiusLight, 0 };
+#if adaptiveStrip
+	addLodLevel(stripLod, mobiusMesh, adaptiveMobius.parameters.size(), adaptiveMobius.rows, mobiusTolerance);
+#else
+	addLodLevel(stripLod, mobiusMesh, mobiusSegments, 2, mobiusTessellationError(uniformMobiusParameters(mobiusSegments, mobiusStep), 2, mobiusWidth));
+#endif
+	addLodLevel(earthLod, earthMesh, stacks, slices, sphereLodError(radius, stacks, slices));
+	addLodLevel(sunLod, sunMesh, stacksLight, slicesLight, sphereLodError(radiusLight, stacksLight, slicesLight));
+
+	int stripSegments[] = { 16, 64, 128 };
+	for (int segments : stripSegments)
 	{
-		mobiusNormals_back.push_back(-mobiusNormals[j]);
+		std::vector<float> parameters = uniformMobiusParameters(segments, 2 * pi / segments);
+		int level = addMesh(meshArena, segments * 2, calculateMobiusLodIndices(segments));
+		setMeshAttribute(meshArena, level, ATTRIBUTE_COLOR, resampleMobiusColors(mobiusColors, parameters, 2));
+		addLodLevel(stripLod, level, segments, 2, mobiusTessellationError(parameters, 2, mobiusWidth));
+		arenaTarget.baseVertex = meshArena.meshes[level].baseVertex;
+		dispatchMobiusMesher(mobiusMesher, arenaTarget, segments, 2, 2 * pi / segments, mobiusWidth);
 	}
-
-	glGenBuffers(1, &VBOnormals_back);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOnormals_back);
-	glBufferData(GL_ARRAY_BUFFER, 4 * mobiusNormals_back.size(), &mobiusNormals_back.front(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-	// create buffer object for indices
-	std::vector<int> mobiusIndices_back;
-	for (int j = 0; j < mobiusIndices.size(); j += 3)
+	int sphereStacks[] = { 4, 16, 32 };
+	for (int levelStacks : sphereStacks)
+	{
+		int levelSlices = levelStacks * 2;
+		int levelVertexCount = (levelStacks + 1) * (levelSlices + 1);
+		int level = addMesh(meshArena, levelVertexCount, calculateSphereLodIndices(levelStacks, levelSlices));
+		addLodLevel(earthLod, level, levelStacks, levelSlices, sphereLodError(radius, levelStacks, levelSlices));
+		if (levelStacks <= 16)
+		{
+			level = addMesh(meshArena, levelVertexCount, calculateSphereLodIndices(levelStacks, levelSlices));
+			addLodLevel(sunLod, level, levelStacks, levelSlices, sphereLodError(radiusLight, levelStacks, levelSlices));
+		}
+	}
+	dispatchSphereLods(sphereMesher, arenaTarget, meshArena, earthLod, radius, glm::vec3(0.0f), earthRotation);
+	dispatchSphereLods(sphereMesher, arenaTarget, meshArena, sunLod, radiusLight, glm::vec3(kreisradius), 0.0f);
+#endif
+#else
+#if useIcosphere
+	std::vector<float> texCoords = icosphere.texCoords;
+#elif bakedMeshes
+	std::vector<float> texCoords(bakedEarth.texCoords.begin(), bakedEarth.texCoords.end());
+#else
+	std::vector<float> texCoords = GenerateSphereTexCoordinates();
+#endif
+	setMeshAttribute(meshArena, mobiusMesh, ATTRIBUTE_POSITION, mobiusVertices);
+	setMeshAttribute(meshArena, mobiusMesh, ATTRIBUTE_NORMAL, mobiusNormals);
+	setMeshAttribute(meshArena, earthMesh, ATTRIBUTE_POSITION, sphereVertices);
+	setMeshAttribute(meshArena, earthMesh, ATTRIBUTE_NORMAL, earthNormals);
+	setMeshAttribute(meshArena, earthMesh, ATTRIBUTE_TEXCOORD, texCoords);
+	setMeshAttribute(meshArena, sunMesh, ATTRIBUTE_POSITION, LightSphereVertices);
+	setMeshAttribute(meshArena, sunMesh, ATTRIBUTE_TEXCOORD, texCoords);
+
+	//the unrotated earth at the moon's size, fillWorldVertices moves it to the moon
+	std::vector<float> moonLocalVertices = sphereVertices;
+	for (float& coordinate : moonLocalVertices)
 	{
-		mobiusIndices_back.push_back(mobiusIndices[j + 2]);
-		mobiusIndices_back.push_back(mobiusIndices[j + 1]);
-		mobiusIndices_back.push_back(mobiusIndices[j]);
+		coordinate *= (float)(radiusMoon / radius);
 	}
-	glGenBuffers(1, &EBO_back);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_back);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, 4 * mobiusIndices_back.size(), &mobiusIndices_back.front(), GL_STATIC_DRAW);
+	std::vector<float> moonLocalNormals = earthNormals;
+	std::vector<float> moonVertices = moonLocalVertices;
+	std::vector<float> moonNormals = moonLocalNormals;
+#if !vertexPulling
+	fillWorldVertices(moonVertices, moonNormals, moonLocalVertices, moonLocalNormals, scene, moonEntity);
+#endif
+	setMeshAttribute(meshArena, moonMesh, ATTRIBUTE_POSITION, moonVertices);
+	setMeshAttribute(meshArena, moonMesh, ATTRIBUTE_NORMAL, moonNormals);
+	setMeshAttribute(meshArena, moonMesh, ATTRIBUTE_TEXCOORD, texCoords);
+#endif
+
+#if quantizedVertices
+	std::vector<StripLayout::Vertex> stripVertices = StripLayout::pack(mobiusVertexCount, mobiusVertices, mobiusNormals, stripColors);
+	std::vector<EarthLayout::Vertex> earthVertices = EarthLayout::pack(sphereVertexCount, sphereVertices, earthNormals, texCoords);
+	std::vector<SunLayout::Vertex> sunVertices = SunLayout::pack(LightSphereVertexCount, LightSphereVertices, texCoords);
+	int mobiusPackedMesh = addPackedMesh(meshArena, StripLayout::stride, mobiusVertexCount, &stripVertices.front(), mobiusIndices);
+	int earthPackedMesh = addPackedMesh(meshArena, EarthLayout::stride, sphereVertexCount, &earthVertices.front(), earthIndices);
+	int sunPackedMesh = addPackedMesh(meshArena, SunLayout::stride, LightSphereVertexCount, &sunVertices.front(), sunIndices);
+	std::vector<EarthLayout::Vertex> moonPackedVertices = EarthLayout::pack(sphereVertexCount, moonVertices, moonNormals, texCoords);
+	int moonPackedMesh = addPackedMesh(meshArena, EarthLayout::stride, sphereVertexCount, &moonPackedVertices.front(), earthIndices);
+
+	//one VAO per layout, all of them read the packed region of the arena
+	GLuint stripVao = StripLayout::createVertexArray(meshArena.buffer, meshArena.packedOffset, meshArena.buffer);
+	GLuint earthVao = EarthLayout::createVertexArray(meshArena.buffer, meshArena.packedOffset, meshArena.buffer);
+	GLuint sunVao = SunLayout::createVertexArray(meshArena.buffer, meshArena.packedOffset, meshArena.buffer);
+#endif
 
 	glUseProgram(shaderTextureProgram);
 	glUniformMatrix4fv(glGetUniformLocation(shaderTextureProgram, "view"), 1, GL_FALSE, &view[0][0]);
 	glUniformMatrix4fv(glGetUniformLocation(shaderTextureProgram, "projection"), 1, GL_FALSE, &proj[0][0]);
 
-
-	// ids for sphere
-	GLuint  sphere_VAO;
-	GLuint  sphere_EBO;
-	GLuint  sphere_VBOnormals;
-	GLuint  sphere_VBOcoords;
-	GLuint  sphere_VBOtex;
-
-	//sphere
-	glGenVertexArrays(1, &sphere_VAO);
-	glBindVertexArray(sphere_VAO);
-
-	//sphere
-	glGenBuffers(1, &sphere_VBOcoords);
-	glBindBuffer(GL_ARRAY_BUFFER, sphere_VBOcoords);
-	glBufferData(GL_ARRAY_BUFFER, 4 * sphereVertices.size(), &sphereVertices.front(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0); //Sphere is position2
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-
-
-	//Sphere Indices
-	glGenBuffers(1, &sphere_EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, 4 * sphereIndices.size(), &sphereIndices.front(), GL_STATIC_DRAW);
-
-	//Sphere Texture Coordinates
-	std::vector<float> texCoords = GenerateSphereTexCoordinates();
-	glGenBuffers(1, &sphere_VBOtex);
-	glBindBuffer(GL_ARRAY_BUFFER, sphere_VBOtex);
-	glBufferData(GL_ARRAY_BUFFER, 4 * texCoords.size(), &texCoords.front(), GL_STATIC_DRAW);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	glEnableVertexAttribArray(2);
-	//Sphere Texture Coordinates
-	glGenBuffers(1, &sphere_VBOnormals);
-	glBindBuffer(GL_ARRAY_BUFFER, sphere_VBOnormals);
-	glBufferData(GL_ARRAY_BUFFER, 4 * earthNormals.size(), &earthNormals.front(), GL_STATIC_DRAW);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	glEnableVertexAttribArray(3);
-
 	//EarthTexture
 	unsigned int textureEarth;
 	glGenTextures(1, &textureEarth);
@@ -629,36 +952,6 @@ int main()
 	glUniformMatrix4fv(glGetUniformLocation(shaderLightProgram, "view"), 1, GL_FALSE, &view[0][0]);
 	glUniformMatrix4fv(glGetUniformLocation(shaderLightProgram, "projection"), 1, GL_FALSE, &proj[0][0]);
 
-	// ids for LightSphere
-	GLuint  LightSphere_VAO;
-	GLuint  LightSphere_EBO;
-	GLuint  LightSphere_VBOcoords;
-	GLuint  LightSphere_VBOtex;
-
-	//Lightsphere
-	glGenVertexArrays(1, &LightSphere_VAO);
-	glBindVertexArray(LightSphere_VAO);
-
-	//Lightsphere
-	glGenBuffers(1, &LightSphere_VBOcoords);
-	glBindBuffer(GL_ARRAY_BUFFER, LightSphere_VBOcoords);
-	glBufferData(GL_ARRAY_BUFFER, 4 * LightSphereVertices.size(), &LightSphereVertices.front(), GL_DYNAMIC_DRAW);
-	glEnableVertexAttribArray(0); //Sphere is position2
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-
-
-	//LightSphere Indices
-	glGenBuffers(1, &LightSphere_EBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, LightSphere_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, 4 * LightSphereIndices.size(), &LightSphereIndices.front(), GL_DYNAMIC_DRAW);
-
-	//LightSphereTexcoordinates
-	glGenBuffers(1, &LightSphere_VBOtex);
-	glBindBuffer(GL_ARRAY_BUFFER, LightSphere_VBOtex);
-	glBufferData(GL_ARRAY_BUFFER, 4 * texCoords.size(), &texCoords.front(), GL_DYNAMIC_DRAW);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	glEnableVertexAttribArray(2);
 	//Sun Texture
 
 	unsigned int textureSun;
@@ -685,61 +978,57 @@ int main()
 	}
 	stbi_image_free(data2);
 
-	float skyboxVertices[] = {
-		// positions          
-		-1.0f,  1.0f, -1.0f,
-		-1.0f, -1.0f, -1.0f,
-		 1.0f, -1.0f, -1.0f,
-		 1.0f, -1.0f, -1.0f,
-		 1.0f,  1.0f, -1.0f,
-		-1.0f,  1.0f, -1.0f,
-
-		-1.0f, -1.0f,  1.0f,
-		-1.0f, -1.0f, -1.0f,
-		-1.0f,  1.0f, -1.0f,
-		-1.0f,  1.0f, -1.0f,
-		-1.0f,  1.0f,  1.0f,
-		-1.0f, -1.0f,  1.0f,
-
-		 1.0f, -1.0f, -1.0f,
-		 1.0f, -1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f, -1.0f,
-		 1.0f, -1.0f, -1.0f,
-
-		-1.0f, -1.0f,  1.0f,
-		-1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f, -1.0f,  1.0f,
-		-1.0f, -1.0f,  1.0f,
-
-		-1.0f,  1.0f, -1.0f,
-		 1.0f,  1.0f, -1.0f,
-		 1.0f,  1.0f,  1.0f,
-		 1.0f,  1.0f,  1.0f,
-		-1.0f,  1.0f,  1.0f,
-		-1.0f,  1.0f, -1.0f,
-
-		-1.0f, -1.0f, -1.0f,
-		-1.0f, -1.0f,  1.0f,
-		 1.0f, -1.0f, -1.0f,
-		 1.0f, -1.0f, -1.0f,
-		-1.0f, -1.0f,  1.0f,
-		 1.0f, -1.0f,  1.0f
-	};
-
+	//Moon Texture, a single grey texel is all it needs
+	unsigned int textureMoon;
+	glGenTextures(1, &textureMoon);
+	glBindTexture(GL_TEXTURE_2D, textureMoon);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	unsigned char moonGrey[] = { 150, 150, 150 };
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, moonGrey);
+
+	setEntityMaterial(scene, earthEntity, textureEarth);
+	setEntityMaterial(scene, moonEntity, textureMoon);
+	setEntityMaterial(scene, sunEntity, textureSun);
+
+#if orbitingBodies || pointLights
+	//one sphere of radius 1 for everything drawn many times, the instance scales it
+	int smallSphereVertexCount = (4 + 1) * (8 + 1);
+	std::vector<float> smallSpherePositions(smallSphereVertexCount * 3);
+	std::vector<float> smallSphereNormals(smallSphereVertexCount * 3);
+	std::vector<float> smallSphereTexCoords(smallSphereVertexCount * 2);
+	fillSphereVertices(smallSpherePositions, 4, 8, 1.0, glm::vec3(0.0f));
+	fillRadialNormals(smallSphereNormals, smallSpherePositions);
+	fillSphereTexCoords(smallSphereTexCoords, 4, 8);
+	int smallSphereMesh = addMesh(meshArena, smallSphereVertexCount, calculateSphereLodIndices(4, 8));
+	setMeshAttribute(meshArena, smallSphereMesh, ATTRIBUTE_POSITION, smallSpherePositions);
+	setMeshAttribute(meshArena, smallSphereMesh, ATTRIBUTE_NORMAL, smallSphereNormals);
+	setMeshAttribute(meshArena, smallSphereMesh, ATTRIBUTE_TEXCOORD, smallSphereTexCoords);
+#endif
+
+#if orbitingBodies
+	//a ring around the earth, inside the strip and tilted towards the camera. The earth is the
+	//fixed attractor, the bodies pull on each other as well
+	NBodySystem bodies = createOrbitingBodies(orbitingBodies, worldPosition(scene, earthEntity), 1.0f, 0.02f, 0.6f, 0.95f, glm::vec3(0.0f, 1.0f, 0.6f), 1);
+	NBodySolver nbodySolver = nbodyBarnesHut ? NBODY_BARNES_HUT : NBODY_DIRECT;
+
+	unsigned int bodyProgram = createShaderProgram(vertexBodyShaderSource, fragmentTextureShaderSource);
+	glUseProgram(bodyProgram);
+	glUniformMatrix4fv(glGetUniformLocation(bodyProgram, "projection"), 1, GL_FALSE, &proj[0][0]);
+	glUniform1i(glGetUniformLocation(bodyProgram, "texture1"), 0);
+	//the instances are written straight into mapped memory, a segment per frame the GPU may be behind
+	StreamBuffer bodyStream = createStreamBuffer(sizeof(float) * 4 * orbitingBodies, frameQueueLength + 1);
+#endif
+
+#if stripParticles
+	StripParticles particles = createStripParticles(stripParticles, mobiusWidth, 1);
+#endif
+
+	//the skybox triangle needs a VAO bound, but no attributes
 	glUseProgram(shaderSkyboxProgram);
-	// skybox VAO
-	unsigned int skyboxVAO, skyboxVBO;
-	glGenVertexArrays(1, &skyboxVAO);
-	glGenBuffers(1, &skyboxVBO);
-	glBindVertexArray(skyboxVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	unsigned int skyboxVao;
+	glGenVertexArrays(1, &skyboxVao);
+	uploadMeshDescriptors(meshArena);
 
 	std::vector<std::string> faces = {
 		std::string("bkg1_right.png"),
@@ -752,6 +1041,84 @@ int main()
 	unsigned int cubemapTexture = loadCubemap(faces);
 	glUniform1i(glGetUniformLocation(shaderSkyboxProgram, std::string("skybox").c_str()), 0);
 
+#if parametricSurfaces
+	unsigned int parametricProgram = createShaderProgram(vertexParametricShaderSource, fragmentShaderSource);
+	unsigned int parametricTextureProgram = createShaderProgram(vertexParametricShaderSource, fragmentTextureShaderSource);
+	unsigned int parametricLightProgram = createShaderProgram(vertexParametricShaderSource, fragmentLightShaderSource);
+	unsigned int parametricPrograms[] = { parametricProgram, parametricTextureProgram, parametricLightProgram };
+	for (unsigned int program : parametricPrograms)
+	{
+		glUseProgram(program);
+		glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, &proj[0][0]);
+	}
+
+	//one grid for every surface, 4 bytes per vertex
+	ParametricGrid parametricGrid = createParametricGrid(parametricGridU, parametricGridV);
+	GLuint paletteBuffer = createPaletteBuffer(mobiusColors);
+
+	ParametricSurface stripSurface = { SURFACE_MOBIUS, 1.0f, mobiusWidth, 1.0f, glm::vec3(0.0f), 0.0f, 0 };
+	ParametricSurface earthSurface = { SURFACE_SPHERE, 0.0f, 0.0f, radius, glm::vec3(0.0f), 0.0f, -1 };
+	ParametricSurface sunSurface = { SURFACE_SPHERE, 0.0f, 0.0f, radiusLight, glm::vec3(kreisradius), 0.0f, -1 };
+	ParametricSurface moonSurface = { SURFACE_SPHERE, 0.0f, 0.0f, radiusMoon, moonMeshCenter, 0.0f, -1 };
+#endif
+
+#if vertexPulling
+	unsigned int pullingProgram = createShaderProgram(vertexPullingShaderSource, fragmentShaderSource);
+	unsigned int pullingTextureProgram = createShaderProgram(vertexPullingShaderSource, fragmentTextureShaderSource);
+	unsigned int pullingLightProgram = createShaderProgram(vertexPullingShaderSource, fragmentLightShaderSource);
+
+	unsigned int pullingPrograms[] = { pullingProgram, pullingTextureProgram, pullingLightProgram };
+	for (unsigned int program : pullingPrograms)
+	{
+		setMeshArenaRegions(program, meshArena);
+		glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, &proj[0][0]);
+	}
+	//the strip colors rotate by shifting the color lookup instead of re-uploading them, see renderFrame
+#endif
+
+#if sphereImpostors
+	//earth, moon and sun, in that order, the bodies bring their own buffer
+	SphereImpostors impostors = createSphereImpostors(3);
+	float impostorSpheres[3 * 4];
+	unsigned int impostorProgram = createImpostorProgram(fragmentImpostorShaderSource);
+	glUseProgram(impostorProgram);
+	glUniform1i(glGetUniformLocation(impostorProgram, "texture1"), 0);
+	unsigned int lightImpostorProgram = createImpostorProgram(fragmentLightImpostorShaderSource);
+	glUseProgram(lightImpostorProgram);
+	glUniform1i(glGetUniformLocation(lightImpostorProgram, "texture1"), 1);
+#endif
+
+#if pointLights
+	ClusteredLights clusteredLights = createClusteredLights(pointLights, 0.1f, 100.0f);
+	//every program that lights with fragmentShaderSource or fragmentTextureShaderSource
+	std::vector<unsigned int> clusteredPrograms = { shaderProgram, shaderTextureProgram };
+#if orbitingBodies
+	clusteredPrograms.push_back(bodyProgram);
+#endif
+#if parametricSurfaces
+	clusteredPrograms.push_back(parametricProgram);
+	clusteredPrograms.push_back(parametricTextureProgram);
+#endif
+#if vertexPulling
+	clusteredPrograms.push_back(pullingProgram);
+	clusteredPrograms.push_back(pullingTextureProgram);
+#endif
+#if sphereImpostors
+	clusteredPrograms.push_back(impostorProgram);
+#endif
+	for (unsigned int program : clusteredPrograms)
+	{
+		setClusterUniforms(program, clusteredLights, screenWidth, screenHeight);
+	}
+	unsigned int pointLightProgram = createShaderProgram(vertexPointLightShaderSource, fragmentPointLightShaderSource);
+	glUseProgram(pointLightProgram);
+	glUniformMatrix4fv(glGetUniformLocation(pointLightProgram, "projection"), 1, GL_FALSE, &proj[0][0]);
+	glUniform1f(glGetUniformLocation(pointLightProgram, "sphereRadius"), pointLightSphereRadius);
+	//the lights move every frame and go straight into mapped memory like the bodies' instances
+	StreamBuffer lightStream = createStreamBuffer(sizeof(float) * lightFloats * pointLights, frameQueueLength + 1);
+	float pointLightTime = 0.0f;
+#endif
+
 	std::cout << "W nach oben bewegen" << std::endl;
 	std::cout << "S nach unten bewegen" << std::endl;
 	std::cout << "A nach links bewegen" << std::endl;
@@ -762,258 +1129,672 @@ int main()
 	std::cout << "K nach unten drehen" << std::endl;
 	std::cout << "J nach links drehen" << std::endl;
 	std::cout << "L nach rechts drehen" << std::endl;
+#if parametricSurfaces
+	std::cout << "1-4 Moebiusband, Kugel, Torus, Kleinsche Flasche" << std::endl;
+#endif
 
-	int i = 0;
 	int lightsphereposition = 0;
-	while (!glfwWindowShouldClose(window))
+	int viewportWidth = screenWidth;
+	int viewportHeight = screenHeight;
+	JobFrame frameJobs;
+	int renderedFrames = 0;
+	//transient data of one frame, every frame starts it over
+	LinearArena frameArena;
+#if lodChains
+	std::vector<std::vector<float>> stripLodColors(stripLod.levels.size());
+#endif
+	std::vector<FrameState> frameStates(frameStateCount);
+	for (FrameState& state : frameStates)
+	{
+		state.scene = scene;
+#if pointLights
+		state.lights.resize(pointLights * lightFloats);
+#endif
+#if orbitingBodies
+		state.bodyInstances.resize(orbitingBodies * 4);
+#endif
+	}
+	int simulatedFrames = 0;
+	int animationSteps = 0;
+	//moves everything on by one frame: input, animation, scene, lights and the CPU jobs. With
+	//renderThread on the main thread, while the render thread draws the frames before
+	auto simulateFrame = [&](GLFWwindow *window)
 	{
-		// per-frame time logic
-		// --------------------
-		float currentFrame = glfwGetTime();
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
+		FramePacket frame = readFrameInput(window);
+		FrameState& state = frameStates[simulatedFrames % frameStateCount];
+		frame.state = simulatedFrames % frameStateCount;
+		simulatedFrames++;
+		resetLinearArena(frameArena);
+
+		if (frame.animationStep)
+		{
+			//Rotation der Erde, Umkreis der Sonne
+			earthRotation += pi / 360;
+			lightsphereposition = lightsphereposition + 3;
+			if (lightsphereposition > LightSphereCenters.size() / 3) { lightsphereposition = 3; };
+			setLocalRotation(scene, earthEntity, earthRotation, glm::vec3(0.0f, 0.0f, 1.0f));
+			setLocalPosition(scene, sunEntity, glm::vec3(LightSphereCenters[lightsphereposition], LightSphereCenters[lightsphereposition + 1], LightSphereCenters[lightsphereposition + 2]));
+			animationSteps++;
+		}
+		frame.earthRotation = earthRotation;
+		frame.sunPosition = lightsphereposition;
+		frame.animationSteps = animationSteps;
+		//nothing to do on the frames in between, the moon follows the earth on the others
+		updateWorldTransforms(scene);
+#if pointLights
+		pointLightTime += pointLightTimeStep;
+		fillOrbitingLights(state.lights, pointLights, pointLightTime);
+#endif
+#if !parametricSurfaces && !vertexPulling
+		//the CPU work of the frame runs as jobs on the pool, the render thread only uploads the results
+		beginJobFrame(frameJobs);
+#if lodChains
+		//the camera moves in processInput, so every object gets its level again each frame
+		float lodPixels = lodPixelsPerUnit(proj, screenHeight);
+		runJob(*threadPool, createJob(frameJobs, nullptr, [&](Job*) { selectLod(stripLod, worldPosition(scene, stripEntity), frame.cameraPos, lodPixels, lodMaxPixelError, lodHysteresis); }));
+		runJob(*threadPool, createJob(frameJobs, nullptr, [&](Job*) { selectLod(earthLod, worldPosition(scene, earthEntity), frame.cameraPos, lodPixels, lodMaxPixelError, lodHysteresis); }));
+		runJob(*threadPool, createJob(frameJobs, nullptr, [&](Job*) { selectLod(sunLod, worldPosition(scene, sunEntity), frame.cameraPos, lodPixels, lodMaxPixelError, lodHysteresis); }));
+#endif
+		if (frame.animationStep)
+		{
+			//the coarser strip levels resample the rotated palette, one child job each
+			runJob(*threadPool, createJob(frameJobs, nullptr, [&](Job* colorJob)
+			{
+				//mobius Farben
+				float s = mobiusColors.at(0);
+				float t = mobiusColors.at(1);
+				float u = mobiusColors.at(2);
+				float v = mobiusColors.at(3);
+				float w = mobiusColors.at(4);
+				float x = mobiusColors.at(5);
+				float y = mobiusColors.at(6);
+				float z = mobiusColors.at(7);
+				mobiusColors.erase(mobiusColors.begin());
+				mobiusColors.erase(mobiusColors.begin());
+				mobiusColors.erase(mobiusColors.begin());
+				mobiusColors.erase(mobiusColors.begin());
+				mobiusColors.erase(mobiusColors.begin());
+				mobiusColors.erase(mobiusColors.begin());
+				mobiusColors.erase(mobiusColors.begin());
+				mobiusColors.erase(mobiusColors.begin());
+				mobiusColors.push_back(s);
+				mobiusColors.push_back(t);
+				mobiusColors.push_back(u);
+				mobiusColors.push_back(v);
+				mobiusColors.push_back(w);
+				mobiusColors.push_back(x);
+				mobiusColors.push_back(y);
+				mobiusColors.push_back(z);
+#if lodChains
+				for (int level = 0; level < (int)stripLod.levels.size(); level++)
+				{
+					if (stripLod.levels[level].mesh != mobiusMesh)
+					{
+						runJob(*threadPool, createJob(frameJobs, colorJob, [&, level](Job*)
+						{
+							//the sample positions are only needed for the resampling, the vectors keep their capacity
+							const LodLevel& lod = stripLod.levels[level];
+							ArenaVector<float> parameters(lod.rows, 0.0f, ArenaAllocator<float>(frameArena));
+							fillUniformMobiusParameters(parameters, 2 * pi / lod.rows);
+							stripLodColors[level].resize(lod.rows * lod.columns * 4);
+							fillResampledMobiusColors(stripLodColors[level], mobiusColors, parameters, lod.columns);
+						}));
+					}
+				}
+#endif
+#if adaptiveStrip
+				fillResampledMobiusColors(stripColors, mobiusColors, adaptiveMobius.parameters, adaptiveMobius.rows);
+#else
+				stripColors = mobiusColors;
+#endif
+#if quantizedVertices
+				StripLayout::packInto(stripVertices, mobiusVertices, mobiusNormals, stripColors);
+#endif
+			}));
+#if !computeMesher
+			//only uploaded after the earth is drawn, the old positions are on the GPU until then
+			runJob(*threadPool, createJob(frameJobs, nullptr, [&](Job*)
+			{
+				RotateEarth(sphereVertices);
+				fillWorldVertices(moonVertices, moonNormals, moonLocalVertices, moonLocalNormals, scene, moonEntity);
+#if quantizedVertices
+				fillRadialNormals(earthNormals, sphereVertices);
+				EarthLayout::packInto(earthVertices, sphereVertices, earthNormals, texCoords);
+				EarthLayout::packInto(moonPackedVertices, moonVertices, moonNormals, texCoords);
+#endif
+			}));
+#endif
+		}
+#if orbitingBodies
+		//the force loop splits itself over the pool from inside the job
+		runJob(*threadPool, createJob(frameJobs, nullptr, [&](Job*)
+		{
+			bodies.attractor = worldPosition(scene, earthEntity);
+			stepNBody(bodies, nbodyTimeStep, nbodySolver, nbodyTheta, *threadPool);
+			fillBodyInstances(state.bodyInstances, bodies, bodyRadius);
+		}));
+#endif
+		endJobFrame(*threadPool, frameJobs);
+#if lodChains
+		setEntityMesh(scene, stripEntity, currentLod(stripLod).mesh);
+		setEntityMesh(scene, earthEntity, currentLod(earthLod).mesh);
+		setEntityMesh(scene, sunEntity, currentLod(sunLod).mesh);
+#endif
+#endif
+		state.scene = scene;
+		return frame;
+	};
 
-		processInput(window);
+	//everything that touches GL, called with one packet of the simulation per frame
+	auto renderFrame = [&](const FramePacket &frame)
+	{
+		beginAllocationFrame(renderedFrames++ >= allocationWarmupFrames);
+		setAllocationPhase(PHASE_DRAW);
+		const FrameState& state = frameStates[frame.state];
+		if (frame.framebufferWidth != viewportWidth || frame.framebufferHeight != viewportHeight)
+		{
+			viewportWidth = frame.framebufferWidth;
+			viewportHeight = frame.framebufferHeight;
+			glViewport(0, 0, viewportWidth, viewportHeight);
+#if pointLights
+			for (unsigned int program : clusteredPrograms)
+			{
+				setClusterUniforms(program, clusteredLights, viewportWidth, viewportHeight);
+			}
+#endif
+		}
 
 		glClearColor(0.0f, 0.5f, 0.0f, 1.0f); //green background
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		glm::vec3 lightPos = worldPosition(state.scene, sunEntity);
+#if pointLights
+		setAllocationPhase(PHASE_UPLOAD);
+		Span<float> lightData = nextStreamSegment(lightStream);
+		if (!lightData.empty())
+		{
+			std::copy(state.lights.begin(), state.lights.end(), lightData.begin());
+		}
+		setAllocationPhase(PHASE_DRAW);
+#endif
+#if pointLights
+		//the clusters of this frame's view, before anything lit is drawn
+		bindStreamSegment(lightStream, LIGHT_BINDING);
+		assignLightsToClusters(clusteredLights, pointLights, frame.view, proj);
+#endif
+#if parametricSurfaces
+		glm::mat4 view = frame.view;
+		//mobius Farben
+		stripSurface.paletteOffset = 2 * frame.animationSteps % (mobiusColors.size() / 4);
+		stripSurface.type = frame.stripSurfaceType;
+		earthSurface.rotation = frame.earthRotation;
+		sunSurface.center = lightPos;
+		moonSurface.center = worldPosition(state.scene, moonEntity);
+		moonSurface.rotation = frame.earthRotation;
+
+		//the grid is shared, so the back of the strip flips the winding instead of using a second index buffer
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_FRONT);
+		glUseProgram(parametricProgram);
+		glUniformMatrix4fv(glGetUniformLocation(parametricProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		glUniform3f(glGetUniformLocation(parametricProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+		setParametricSurface(parametricProgram, stripSurface);
+		drawParametricGrid(parametricGrid);
+		glFrontFace(GL_CW);
+		drawParametricGrid(parametricGrid);
+		glFrontFace(GL_CCW);
+		glDisable(GL_CULL_FACE);
+
+		glUseProgram(parametricTextureProgram);
+		glUniformMatrix4fv(glGetUniformLocation(parametricTextureProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		glUniform1i(glGetUniformLocation(parametricTextureProgram, "texture1"), 0);
+		glUniform3f(glGetUniformLocation(parametricTextureProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, earthEntity));
+		setParametricSurface(parametricTextureProgram, earthSurface);
+		drawParametricGrid(parametricGrid);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, moonEntity));
+		setParametricSurface(parametricTextureProgram, moonSurface);
+		drawParametricGrid(parametricGrid);
+
+		glUseProgram(parametricLightProgram);
+		glUniformMatrix4fv(glGetUniformLocation(parametricLightProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		glUniform1i(glGetUniformLocation(parametricLightProgram, "texture1"), 1);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, sunEntity));
+		setParametricSurface(parametricLightProgram, sunSurface);
+		drawParametricGrid(parametricGrid);
+#elif vertexPulling
+		glm::mat4 view = frame.view;
+		//mobius Farben
+		int mobiusColorShift = 2 * frame.animationSteps % mobiusVertexCount;
+		glm::mat4 stripModel = worldMatrix(state.scene, stripEntity);
+		glm::mat4 earthModel = worldMatrix(state.scene, earthEntity);
+		glm::mat4 moonModel = worldMatrix(state.scene, moonEntity);
+		//the sun's mesh is generated around its starting point
+		glm::mat4 sunModel = glm::translate(worldMatrix(state.scene, sunEntity), -glm::vec3(kreisradius));
+
+		//every draw reads from the same buffer, nothing to rebind between meshes
+		bindMeshArena(meshArena);
+
+		glEnable(GL_CULL_FACE);
+		glCullFace(GL_FRONT);
+		glUseProgram(pullingProgram);
+		glUniformMatrix4fv(glGetUniformLocation(pullingProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(pullingProgram, "model"), 1, GL_FALSE, &stripModel[0][0]);
+		glUniform3f(glGetUniformLocation(pullingProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+		glUniform1i(glGetUniformLocation(pullingProgram, "colorShift"), mobiusColorShift);
+		drawPulledMesh(meshArena, pullingProgram, entityMesh(state.scene, stripEntity));
+		glFrontFace(GL_CW);
+		drawPulledMesh(meshArena, pullingProgram, entityMesh(state.scene, stripEntity));
+		glFrontFace(GL_CCW);
+		glDisable(GL_CULL_FACE);
+
+		glUseProgram(pullingTextureProgram);
+		glUniformMatrix4fv(glGetUniformLocation(pullingTextureProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(pullingTextureProgram, "model"), 1, GL_FALSE, &earthModel[0][0]);
+		glUniform1i(glGetUniformLocation(pullingTextureProgram, "texture1"), 0);
+		glUniform3f(glGetUniformLocation(pullingTextureProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, earthEntity));
+		drawPulledMesh(meshArena, pullingTextureProgram, entityMesh(state.scene, earthEntity));
+		glUniformMatrix4fv(glGetUniformLocation(pullingTextureProgram, "model"), 1, GL_FALSE, &moonModel[0][0]);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, moonEntity));
+		drawPulledMesh(meshArena, pullingTextureProgram, entityMesh(state.scene, moonEntity));
+
+		glUseProgram(pullingLightProgram);
+		glUniformMatrix4fv(glGetUniformLocation(pullingLightProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		glUniformMatrix4fv(glGetUniformLocation(pullingLightProgram, "model"), 1, GL_FALSE, &sunModel[0][0]);
+		glUniform1i(glGetUniformLocation(pullingLightProgram, "texture1"), 1);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, sunEntity));
+		drawPulledMesh(meshArena, pullingLightProgram, entityMesh(state.scene, sunEntity));
+#else
 		glEnable(GL_CULL_FACE);
 		glCullFace(GL_FRONT);
 		glUseProgram(shaderProgram);
 
-		glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+		glm::mat4 view = frame.view;
 		glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &view[0][0]);
-		glUniform3f(glGetUniformLocation(shaderProgram, "lightPos"), LightSphereCenters[lightsphereposition], LightSphereCenters[lightsphereposition + 1], LightSphereCenters[lightsphereposition + 2]);
+		glUniform3f(glGetUniformLocation(shaderProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
 
-		glBindVertexArray(VAO);
-		i++;
+		//every mesh lives in the arena, one VAO for all of them
+		bindMeshArena(meshArena);
 
-		
-		if (i >= 60)
+#if orbitingBodies
+		setAllocationPhase(PHASE_UPLOAD);
+		Span<float> bodyInstances = nextStreamSegment(bodyStream);
+		if (!bodyInstances.empty())
 		{
-
-			//mobius Farben
-			float s = mobiusColors.at(0);
-			float t = mobiusColors.at(1);
-			float u = mobiusColors.at(2);
-			float v = mobiusColors.at(3);
-			float w = mobiusColors.at(4);
-			float x = mobiusColors.at(5);
-			float y = mobiusColors.at(6);
-			float z = mobiusColors.at(7);
-			mobiusColors.erase(mobiusColors.begin());
-			mobiusColors.erase(mobiusColors.begin());
-			mobiusColors.erase(mobiusColors.begin());
-			mobiusColors.erase(mobiusColors.begin());
-			mobiusColors.erase(mobiusColors.begin());
-			mobiusColors.erase(mobiusColors.begin());
-			mobiusColors.erase(mobiusColors.begin());
-			mobiusColors.erase(mobiusColors.begin());
-			mobiusColors.push_back(s);
-			mobiusColors.push_back(t);
-			mobiusColors.push_back(u);
-			mobiusColors.push_back(v);
-			mobiusColors.push_back(w);
-			mobiusColors.push_back(x);
-			mobiusColors.push_back(y);
-			mobiusColors.push_back(z);
-			glBindBuffer(GL_ARRAY_BUFFER, colorbuffer);
-			glBufferData(GL_ARRAY_BUFFER, 6 * mobiusColors.size(), &mobiusColors.front(), GL_STATIC_DRAW);
-			glEnableVertexAttribArray(1);
-			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, (void*)0);
+			std::copy(state.bodyInstances.begin(), state.bodyInstances.end(), bodyInstances.begin());
 		}
-		
+#endif
 
-		glUseProgram(shaderProgram);
-		glDrawElements(GL_TRIANGLES, mobiusIndices.size(), GL_UNSIGNED_INT, 0);
-
-		glBindVertexArray(VAO_back);
-
-		if (i >= 60)
+		setAllocationPhase(PHASE_UPLOAD);
+		if (frame.animationStep)
 		{
-			glBindBuffer(GL_ARRAY_BUFFER, colorbuffer_back);
-			glBufferData(GL_ARRAY_BUFFER, 6 * mobiusColors.size(), &mobiusColors.front(), GL_STATIC_DRAW);
-			glEnableVertexAttribArray(1);
-			glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 0, (void*)0);
+#if quantizedVertices
+			setPackedVertices(meshArena, mobiusPackedMesh, &stripVertices.front());
+#else
+			setMeshAttribute(meshArena, mobiusMesh, ATTRIBUTE_COLOR, stripColors);
+#endif
+#if lodChains
+			for (int level = 0; level < (int)stripLod.levels.size(); level++)
+			{
+				if (stripLod.levels[level].mesh != mobiusMesh)
+				{
+					setMeshAttribute(meshArena, stripLod.levels[level].mesh, ATTRIBUTE_COLOR, stripLodColors[level]);
+				}
+			}
+#endif
 		}
 
-		glDrawElements(GL_TRIANGLES, mobiusIndices.size(), GL_UNSIGNED_INT, 0);
+		setAllocationPhase(PHASE_DRAW);
+		glUseProgram(shaderProgram);
+#if quantizedVertices
+		glBindVertexArray(stripVao);
+		drawMesh(meshArena, mobiusPackedMesh);
+		glFrontFace(GL_CW);
+		drawMesh(meshArena, mobiusPackedMesh);
+		glFrontFace(GL_CCW);
+#else
+		drawMesh(meshArena, entityMesh(state.scene, stripEntity));
+
+		//back of the strip, the same triangles with the winding flipped
+		glFrontFace(GL_CW);
+		drawMesh(meshArena, entityMesh(state.scene, stripEntity));
+		glFrontFace(GL_CCW);
+#endif
 
 		glDisable(GL_CULL_FACE);
 
-		glBindVertexArray(sphere_VAO);
-
 		glUseProgram(shaderTextureProgram);
 		glUniformMatrix4fv(glGetUniformLocation(shaderTextureProgram, "view"), 1, GL_FALSE, &view[0][0]);
 
 		glUniform1i(glGetUniformLocation(shaderTextureProgram, "texture1"), 0);
-		glUniform3f(glGetUniformLocation(shaderTextureProgram, "lightPos"), LightSphereCenters[lightsphereposition], LightSphereCenters[lightsphereposition + 1], LightSphereCenters[lightsphereposition + 2]);
+		glUniform3f(glGetUniformLocation(shaderTextureProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, textureEarth);
-		glDrawElements(GL_TRIANGLES, sphereIndices.size(), GL_UNSIGNED_INT, 0);
-
-
-		glBindVertexArray(sphere_VAO);
-		if (i >= 60)
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, earthEntity));
+#if sphereImpostors
+		//the spheres straight from their entities, the meshes are left alone
+		glm::mat4 viewProjection = proj * view;
+		int sphereEntities[3] = { earthEntity, moonEntity, sunEntity };
+		for (int k = 0; k < 3; k++)
 		{
-			//Rotation der Erde
-			RotateEarth(sphereVertices);
-			glBindBuffer(GL_ARRAY_BUFFER, sphere_VBOcoords);
-			glBufferData(GL_ARRAY_BUFFER, 4 * sphereVertices.size(), &sphereVertices.front(), GL_DYNAMIC_DRAW);
-			glEnableVertexAttribArray(0); //Sphere is position2
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-			earthNormals = calculateEarthNormals(sphereVertices);
-			glBindBuffer(GL_ARRAY_BUFFER, sphere_VBOnormals);
-			glBufferData(GL_ARRAY_BUFFER, 4 * earthNormals.size(), &earthNormals.front(), GL_STATIC_DRAW);
-			glEnableVertexAttribArray(3);
-			glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-
+			glm::vec3 center = worldPosition(state.scene, sphereEntities[k]);
+			impostorSpheres[k * 4] = center.x;
+			impostorSpheres[k * 4 + 1] = center.y;
+			impostorSpheres[k * 4 + 2] = center.z;
+			impostorSpheres[k * 4 + 3] = worldBoundsRadius(state.scene, sphereEntities[k]);
+		}
+		setImpostorSpheres(impostors, Span<const float>(impostorSpheres, 3 * 4));
+		bindImpostorSpheres(impostors);
+		glUseProgram(impostorProgram);
+		glUniformMatrix4fv(glGetUniformLocation(impostorProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		glUniform3f(glGetUniformLocation(impostorProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+		setImpostorCamera(impostorProgram, viewProjection, frame.cameraPos);
+		setImpostorOrientation(impostorProgram, worldMatrix(state.scene, earthEntity));
+		drawSphereImpostors(impostors, impostorProgram, 0, 1);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, moonEntity));
+		setImpostorOrientation(impostorProgram, worldMatrix(state.scene, moonEntity));
+		drawSphereImpostors(impostors, impostorProgram, 1, 1);
+#elif quantizedVertices
+		glBindVertexArray(earthVao);
+		drawMesh(meshArena, earthPackedMesh);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, moonEntity));
+		drawMesh(meshArena, moonPackedMesh);
+#else
+		drawMesh(meshArena, entityMesh(state.scene, earthEntity));
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, moonEntity));
+		drawMesh(meshArena, entityMesh(state.scene, moonEntity));
+#endif
+#if orbitingBodies
+		//all bodies in one draw, in the moon's grey
+#if sphereImpostors
+		bindStreamSegment(bodyStream, SPHERE_IMPOSTOR_BINDING);
+		setImpostorOrientation(impostorProgram, glm::mat4(1.0f));
+		drawSphereImpostors(impostors, impostorProgram, 0, bodies.count);
+#else
+		glUseProgram(bodyProgram);
+		glUniformMatrix4fv(glGetUniformLocation(bodyProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		glUniform3f(glGetUniformLocation(bodyProgram, "lightPos"), lightPos.x, lightPos.y, lightPos.z);
+		bindMeshArena(meshArena);
+		bindStreamSegment(bodyStream, 6);
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, moonEntity));
+		drawMeshInstanced(meshArena, smallSphereMesh, bodies.count);
+#endif
+		fenceStreamSegment(bodyStream);
+#endif
+
+		setAllocationPhase(PHASE_UPLOAD);
+		if (frame.animationStep)
+		{
+			//Rotation der Erde, the moon goes along
+#if computeMesher
+#if lodChains
+			dispatchSphereLods(sphereMesher, arenaTarget, meshArena, earthLod, radius, worldPosition(state.scene, earthEntity), frame.earthRotation);
+#else
+			arenaTarget.baseVertex = meshArena.meshes[earthMesh].baseVertex;
+			dispatchSphereMesher(sphereMesher, arenaTarget, stacks, slices, radius, worldPosition(state.scene, earthEntity), frame.earthRotation);
+#endif
+			arenaTarget.baseVertex = meshArena.meshes[moonMesh].baseVertex;
+			dispatchSphereMesher(sphereMesher, arenaTarget, stacksLight, slicesLight, radiusMoon, worldPosition(state.scene, moonEntity), frame.earthRotation);
+#else
+#if quantizedVertices
+			setPackedVertices(meshArena, earthPackedMesh, &earthVertices.front());
+			setPackedVertices(meshArena, moonPackedMesh, &moonPackedVertices.front());
+#else
+			setMeshAttribute(meshArena, earthMesh, ATTRIBUTE_POSITION, sphereVertices);
+			//nothing on the CPU reads the normals again, they are written into the arena directly
+			Span<float> mappedNormals = mapMeshAttribute(meshArena, earthMesh, ATTRIBUTE_NORMAL);
+			if (!mappedNormals.empty())
+			{
+				fillRadialNormals(mappedNormals, sphereVertices);
+				unmapMeshArena(meshArena);
+			}
+			setMeshAttribute(meshArena, moonMesh, ATTRIBUTE_POSITION, moonVertices);
+			setMeshAttribute(meshArena, moonMesh, ATTRIBUTE_NORMAL, moonNormals);
+#endif
+#endif
 		}
+		setAllocationPhase(PHASE_DRAW);
 
 		glUseProgram(shaderLightProgram);
 		glUniformMatrix4fv(glGetUniformLocation(shaderTextureProgram, "view"), 1, GL_FALSE, &view[0][0]);
-		glBindVertexArray(LightSphere_VAO);
-		if (i >= 60)
+		setAllocationPhase(PHASE_UPLOAD);
+		if (frame.animationStep)
 		{
 			//Umkreis der Sonne
-			lightsphereposition = lightsphereposition + 3;
-			AdjustVertexData(lightsphereposition, LightSphereCenters, LightSphereVertices);
-			glBindBuffer(GL_ARRAY_BUFFER, LightSphere_VBOcoords);
-			glBufferData(GL_ARRAY_BUFFER, 4 * LightSphereVertices.size(), &LightSphereVertices.front(), GL_DYNAMIC_DRAW);
-			glEnableVertexAttribArray(0); //Sphere is position2
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-			if (lightsphereposition > LightSphereCenters.size() / 3) { lightsphereposition = 3; };
-			i = 0;
+#if computeMesher
+			glm::vec3 center = worldPosition(state.scene, sunEntity);
+#if lodChains
+			dispatchSphereLods(sphereMesher, arenaTarget, meshArena, sunLod, radiusLight, center, 0.0f);
+#else
+			arenaTarget.baseVertex = meshArena.meshes[sunMesh].baseVertex;
+			dispatchSphereMesher(sphereMesher, arenaTarget, stacksLight, slicesLight, radiusLight, center, 0.0f);
+#endif
+			glUseProgram(shaderLightProgram);
+#else
+#if useIcosphere
+			glm::vec3 center = worldPosition(state.scene, sunEntity);
+			fillPlacedIcosphere(LightSphereVertices, icosphere, radiusLight, center, 0.0f);
+#elif quantizedVertices
+			AdjustVertexData(frame.sunPosition, LightSphereCenters, LightSphereVertices);
+#else
+			//moved straight into the arena, LightSphereVertices keeps the start position
+			Span<float> mappedPositions = mapMeshAttribute(meshArena, sunMesh, ATTRIBUTE_POSITION);
+			if (!mappedPositions.empty())
+			{
+				AdjustVertexData(frame.sunPosition, LightSphereCenters, mappedPositions);
+				unmapMeshArena(meshArena);
+			}
+#endif
+#if quantizedVertices
+			SunLayout::packInto(sunVertices, LightSphereVertices, texCoords);
+			setPackedVertices(meshArena, sunPackedMesh, &sunVertices.front());
+#elif useIcosphere
+			setMeshAttribute(meshArena, sunMesh, ATTRIBUTE_POSITION, LightSphereVertices);
+#endif
+#endif
 		}
+		setAllocationPhase(PHASE_DRAW);
 
 		glUniform1i(glGetUniformLocation(shaderLightProgram, "texture1"), 1);
 		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, textureSun);
-		glDrawElements(GL_TRIANGLES, LightSphereIndices.size(), GL_UNSIGNED_INT, 0);
-
-		glBindBuffer(GL_ARRAY_BUFFER, LightSphere_VBOcoords);
-		glBufferData(GL_ARRAY_BUFFER, 4 * LightSphereVertices.size(), &LightSphereVertices.front(), GL_DYNAMIC_DRAW);
-		glEnableVertexAttribArray(0); //Sphere is position2
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
+		glBindTexture(GL_TEXTURE_2D, entityMaterial(state.scene, sunEntity));
+#if sphereImpostors
+		glUseProgram(lightImpostorProgram);
+		setImpostorCamera(lightImpostorProgram, viewProjection, frame.cameraPos);
+		setImpostorOrientation(lightImpostorProgram, worldMatrix(state.scene, sunEntity));
+		bindImpostorSpheres(impostors);
+		drawSphereImpostors(impostors, lightImpostorProgram, 2, 1);
+#elif quantizedVertices
+		glBindVertexArray(sunVao);
+		drawMesh(meshArena, sunPackedMesh);
+#else
+		drawMesh(meshArena, entityMesh(state.scene, sunEntity));
+#endif
+#endif
+
+#if pointLights
+		glUseProgram(pointLightProgram);
+		glUniformMatrix4fv(glGetUniformLocation(pointLightProgram, "view"), 1, GL_FALSE, &view[0][0]);
+		bindMeshArena(meshArena);
+		drawMeshInstanced(meshArena, smallSphereMesh, pointLights);
+#endif
+
+#if stripParticles
+		//only the Möbius strip, the other parametric surfaces have parameters of their own
+		if (frame.stripSurfaceType == SURFACE_MOBIUS)
+		{
+			glm::mat4 viewProjection = proj * view;
+			updateStripParticles(particles, particleTimeStep, particleLift, worldMatrix(state.scene, stripEntity), viewProjection);
+			drawStripParticles(particles, viewProjection, proj, particleSize, viewportHeight);
+		}
+#endif
 
 		// draw skybox as last
 		glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
 		glUseProgram(shaderSkyboxProgram);
 		glm::mat4 viewSky = glm::mat4(glm::mat3(view)); // remove translation from the view matrix
-		glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, &viewSky[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &proj[0][0]);
+		glm::mat4 inverseSky = glm::inverse(proj * viewSky);
+		glUniformMatrix4fv(glGetUniformLocation(shaderSkyboxProgram, "inverseViewProjection"), 1, GL_FALSE, &inverseSky[0][0]);
 
-		// skybox cube
-		glBindVertexArray(skyboxVAO);
+		// skybox triangle, only the pixels nothing else covered are still at the far plane
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
+		glBindVertexArray(skyboxVao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
 		glBindVertexArray(0);
 		glDepthFunc(GL_LESS);
+#if pointLights
+		//the lit draws of the whole frame read the segment
+		fenceStreamSegment(lightStream);
+#endif
 
 		glUseProgram(0);
 		glfwSwapBuffers(window);
+		endAllocationFrame();
+	};
+
+#if renderThread
+	//from here on the context belongs to the render thread, this one only polls events and simulates
+	SpscQueue<FramePacket, frameQueueLength> frameQueue;
+	glfwMakeContextCurrent(NULL);
+	std::thread renderer([&]()
+	{
+		glfwMakeContextCurrent(window);
+		FramePacket frame;
+		while (true)
+		{
+			pop(frameQueue, frame);
+			if (frame.quit)
+			{
+				break;
+			}
+			renderFrame(frame);
+		}
+		glfwMakeContextCurrent(NULL);
+	});
+
+	while (!glfwWindowShouldClose(window))
+	{
+		setAllocationPhase(PHASE_INPUT);
+		glfwPollEvents();
+		FramePacket frame = simulateFrame(window);
+		//a full queue means the render thread is frameQueueLength frames behind, sleep until it catches up
+		push(frameQueue, frame);
+	}
+	FramePacket quit = FramePacket();
+	quit.quit = true;
+	push(frameQueue, quit);
+	renderer.join();
+	glfwMakeContextCurrent(window);
+#else
+	while (!glfwWindowShouldClose(window))
+	{
+		renderFrame(simulateFrame(window));
+		setAllocationPhase(PHASE_INPUT);
 		glfwPollEvents();
 	}
+#endif
 
+	setGeneratorPool(nullptr);
+	destroyThreadPool(threadPool);
 	glfwTerminate();
-	return 0;
+	//with the tracker built in, a frame that allocated after warm-up fails the run
+	return allocatingSteadyFrames() > 0 ? 1 : 0;
 }
 
-void RotateEarth(std::vector<float> &sphere)
+void printMeshReport()
 {
-	std::vector<float> temp;
-	int i = 0;
-	float a = pi / 360;
-
-	while (i < sphere.size())
+	std::cout << "average cache miss ratio, generation order -> optimized" << std::endl;
+	printCacheReport("Moebiusband", calculateMobiusIndices(64 * 3), calculateMobiusVertices());
+	printCacheReport("Erde", calculateSphereIndices(), calculateSphereVertices());
+	printCacheReport("Sonne", calculateLightSphereIndices(), calculateLightSphereVertices());
+	IcosphereMesh icosphere = createIcosphere(icosphereSubdivisions);
+	printCacheReport("Ikosaeder-Kugel", icosphere.indices, icosphere.positions);
+
+	//a high resolution strip, 1024 segments along and 16 across, triangulated row by row
+	int segments = 1024;
+	int rows = 16;
+	std::vector<float> gridVertices;
+	for (int row = 0; row <= rows; row++)
 	{
-		float x = cos(a)*sphere.at(i) - sin(a)*sphere.at(i + 1);
-		float y = sin(a)*sphere.at(i) + cos(a)*sphere.at(i + 1);
-		float z = sphere.at(i + 2);
-		temp.push_back(x);
-		temp.push_back(y);
-		temp.push_back(z);
-		i = i + 3;
+		float s = -mobiusWidth + 2 * mobiusWidth * row / rows;
+		for (int segment = 0; segment <= segments; segment++)
+		{
+			float a = 2 * pi * segment / segments;
+			gridVertices.push_back((1 + s * cos(a / 2)) * cos(a));
+			gridVertices.push_back((1 + s * cos(a / 2)) * sin(a));
+			gridVertices.push_back(s * sin(a / 2));
+		}
 	}
-	sphere = temp;
+	printCacheReport("Moebiusband 1024x16", stripsToTriangles(gridTriangleStrips(rows, segments)), gridVertices);
 }
 
-void AdjustVertexData(int lightposition, std::vector<float> &LightSphereCenters, std::vector<float> &LightSphere)
+void RotateEarth(std::vector<float> &sphere)
 {
-	std::vector<float> temp;
-	for (unsigned int stackNumber = 0; stackNumber <= stacksLight; ++stackNumber)
+	//in place, every vertex only needs its own old x and y
+	float a = pi / 360;
+	for (int i = 0; i + 2 < (int)sphere.size(); i += 3)
 	{
-		for (unsigned int sliceNumber = 0; sliceNumber <= slicesLight; ++sliceNumber)
-		{
-			float theta = stackNumber * pi / stacksLight;
-			float phi = sliceNumber * 2 * pi / slicesLight;
-			float sinTheta = std::sin(theta);
-			float sinPhi = std::sin(phi);
-			float cosTheta = std::cos(theta);
-			float cosPhi = std::cos(phi);
-			temp.push_back(radiusLight * cosPhi * sinTheta + LightSphereCenters.at(lightposition));
-			temp.push_back(radiusLight * sinPhi * sinTheta + LightSphereCenters.at(lightposition + 1));
-			temp.push_back(radiusLight * cosTheta + LightSphereCenters.at(lightposition + 2));
-		}
+		float x = cos(a)*sphere[i] - sin(a)*sphere[i + 1];
+		float y = sin(a)*sphere[i] + cos(a)*sphere[i + 1];
+		sphere[i] = x;
+		sphere[i + 1] = y;
 	}
-	LightSphere = temp;
 }
 
-
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+//grid of a sphere the mesher writes with sphereStacks x sphereSlices, in the index format of the earth mesh
+PackedIndices calculateSphereLodIndices(int sphereStacks, int sphereSlices)
 {
-	glViewport(0, 0, width, height);
+	int vertexCount = (sphereStacks + 1) * (sphereSlices + 1);
+#if restartStrips
+	return packIndices(GL_TRIANGLE_STRIP, gridTriangleStrips(sphereStacks, sphereSlices), vertexCount);
+#else
+	std::vector<int> triangles = stripsToTriangles(gridTriangleStrips(sphereStacks, sphereSlices));
+#if optimizeIndices
+	triangles = optimizeVertexCache(triangles, vertexCount, 16);
+#endif
+	return packIndices(GL_TRIANGLES, triangles, vertexCount);
+#endif
 }
 
-std::vector<float> calculateMobiusVertices(int rootOfVertices) {
-	std::vector<float> mobius;
-	double a = 0;
-	while (a < 2 * pi) {
-		float u = cos(a)* (1 + (-0.5 * cos(a / 2)));
-		mobius.push_back(u);
-
-		float v = sin(a)* (1 + (-0.5 * cos(a / 2)));
-		mobius.push_back(v);
-
-		float w = -0.5 * sin(a / 2);
-		mobius.push_back(w);
-
-		float x = cos(a)* (1 + (0.5 * cos(a / 2)));
-		mobius.push_back(x);
-
-		float y = sin(a)* (1 + (0.5 * cos(a / 2)));
-		mobius.push_back(y);
-
-		float z = 0.5 * sin(a / 2);
-		mobius.push_back(z);
-		a = a + 0.2;
+//every level is kept current, so switching levels never shows an old rotation or position
+void dispatchSphereLods(unsigned int program, MesherTarget &target, MeshArena &meshArena, LodChain &chain, float sphereRadius, glm::vec3 center, float rotation)
+{
+	for (const LodLevel& level : chain.levels)
+	{
+		target.baseVertex = meshArena.meshes[level.mesh].baseVertex;
+		dispatchSphereMesher(program, target, level.rows, level.columns, sphereRadius, center, rotation);
+	}
+}
 
+void AdjustVertexData(int lightposition, std::vector<float> &LightSphereCenters, Span<float> LightSphere)
+{
+#if bakedMeshes
+	//the baked sphere only has to be moved to the new center
+	for (int j = 0; j < bakedLightSphere.positions.count; j++)
+	{
+		LightSphere[j] = bakedLightSphere.positions[j] + LightSphereCenters.at(lightposition + j % 3);
 	}
+#else
+	glm::vec3 center = glm::vec3(LightSphereCenters.at(lightposition), LightSphereCenters.at(lightposition + 1), LightSphereCenters.at(lightposition + 2));
+	fillSphereVertices(LightSphere, stacksLight, slicesLight, radiusLight, center);
+#endif
+}
+
+std::vector<float> calculateMobiusVertices() {
+	std::vector<float> mobius(mobiusVertexCount(mobiusStep) * 3);
+	fillMobiusVertices(mobius, mobiusStep, mobiusWidth);
 	return mobius;
 }
 
 
-std::vector<float> calculateSphereVertices(int rootOfVertices) {
-	std::vector<float> sphere;
-	for (unsigned int stackNumber = 0; stackNumber <= stacks; ++stackNumber)
-	{
-		for (unsigned int sliceNumber = 0; sliceNumber <= slices; ++sliceNumber)
-		{
-			float theta = stackNumber * pi / stacks;
-			float phi = sliceNumber * 2 * pi / slices;
-			float sinTheta = std::sin(theta);
-			float sinPhi = std::sin(phi);
-			float cosTheta = std::cos(theta);
-			float cosPhi = std::cos(phi);
-			sphere.push_back(radius * cosPhi * sinTheta);
-			sphere.push_back(radius * sinPhi * sinTheta);
-			sphere.push_back(radius * cosTheta);
-		}
-	}
+std::vector<float> calculateSphereVertices() {
+	std::vector<float> sphere(sphereVertexCount(stacks, slices) * 3);
+	fillSphereVertices(sphere, stacks, slices, radius, glm::vec3(0.0f));
 	return sphere;
 }
 
@@ -1032,23 +1813,9 @@ std::vector<float> calculateLightSphereCenters(int rootOfVertices) {
 	return LightSphereCenters;
 }
 
-std::vector<float> calculateLightSphereVertices(int rootOfVertices) {
-	std::vector<float> LightSphere;
-	for (unsigned int stackNumber = 0; stackNumber <= stacksLight; ++stackNumber)
-	{
-		for (unsigned int sliceNumber = 0; sliceNumber <= slicesLight; ++sliceNumber)
-		{
-			float theta = stackNumber * pi / stacksLight;
-			float phi = sliceNumber * 2 * pi / slicesLight;
-			float sinTheta = std::sin(theta);
-			float sinPhi = std::sin(phi);
-			float cosTheta = std::cos(theta);
-			float cosPhi = std::cos(phi);
-			LightSphere.push_back(radiusLight * cosPhi * sinTheta + kreisradius);
-			LightSphere.push_back(radiusLight * sinPhi * sinTheta + kreisradius);
-			LightSphere.push_back(radiusLight * cosTheta + kreisradius);
-		}
-	}
+std::vector<float> calculateLightSphereVertices() {
+	std::vector<float> LightSphere(sphereVertexCount(stacksLight, slicesLight) * 3);
+	fillSphereVertices(LightSphere, stacksLight, slicesLight, radiusLight, glm::vec3(kreisradius));
 	return LightSphere;
 }
 
@@ -1083,81 +1850,62 @@ std::vector<int> calculateMobiusIndices(int rootOfIndices) {
 	return mobiusIndices;
 }
 
-std::vector<int> calculateSphereIndices(int rootOfIndices) {
-	std::vector<int> sphereIndices;
-	for (unsigned int stackNumber = 0; stackNumber < stacks; ++stackNumber)
-	{
-		for (unsigned int sliceNumber = 0; sliceNumber <= slices; ++sliceNumber)
-		{
-			sphereIndices.push_back((stackNumber * (slices + 1)) + sliceNumber);
-			sphereIndices.push_back(((stackNumber + 1) * (slices + 1)) + sliceNumber);
-		}
-	}
-	//create triangle out of triangle-strip 
-	std::vector<int> sphereIndices2;
-	int i = 0;
-
-	while (i < sphereIndices.size()) {
-		if (i == sphereIndices.size() - 2) {
-			break;
-		}
-		sphereIndices2.push_back(sphereIndices.at(i));
-		i++;
-		sphereIndices2.push_back(sphereIndices.at(i));
-		i++;
+//closed strip with "segments" steps of 2 pi / segments, laid out like the mobius mesher writes it
+std::vector<int> calculateMobiusLodIndices(int segments) {
+	std::vector<int> mobiusIndices = mobiusStripIndices(segments, 2);
+#if optimizeIndices
+	mobiusIndices = optimizeVertexCache(mobiusIndices, segments * 2, 16);
+#endif
+	return mobiusIndices;
+}
 
-		sphereIndices2.push_back(sphereIndices.at(i));
-		i--;
-	}
-	//correct rotation of normalized vectors
-	i = 0;
-	int temp = 0;
-	while (i < sphereIndices2.size() - 3) {
-		i = i + 3;
-		temp = sphereIndices2.at(i);
-		sphereIndices2.at(i) = sphereIndices2.at(i + 1);
-		sphereIndices2.at(i + 1) = temp;
-		i = i + 3;
-	};
-	return sphereIndices2;
+//colors of the 32 segment strip stretched over the samples at "parameters", blended between two
+//source segments and from the inner to the outer edge across the rows. Past the last source
+//segment the first one follows with inner and outer color swapped
+std::vector<float> resampleMobiusColors(std::vector<float> &mobiusColors, const std::vector<float> &parameters, int rows) {
+	std::vector<float> colors(parameters.size() * rows * 4);
+	fillResampledMobiusColors(colors, mobiusColors, parameters, rows);
+	return colors;
 }
 
-std::vector<int> calculateLightSphereIndices(int rootOfIndices) {
-	std::vector<int> sphereIndices;
-	for (unsigned int stackNumber = 0; stackNumber < stacksLight; ++stackNumber)
+//vec4 per row and parameter, colors has room for parameters.size * rows of them
+void fillResampledMobiusColors(Span<float> colors, const std::vector<float> &mobiusColors, Span<const float> parameters, int rows) {
+	int sourceSegments = mobiusColors.size() / 8;
+	int j = 0;
+	for (float a : parameters)
 	{
-		for (unsigned int sliceNumber = 0; sliceNumber <= slicesLight; ++sliceNumber)
+		float position = a / (2 * pi) * sourceSegments;
+		int source = (int)position % sourceSegments;
+		float blend = position - (int)position;
+		bool wraps = source + 1 == sourceSegments;
+		int next = wraps ? 0 : source + 1;
+		for (int row = 0; row < rows; row++)
 		{
-			sphereIndices.push_back((stackNumber * (slicesLight + 1)) + sliceNumber);
-			sphereIndices.push_back(((stackNumber + 1) * (slicesLight + 1)) + sliceNumber);
+			float across = (float)row / (rows - 1);
+			for (int channel = 0; channel < 4; channel++)
+			{
+				float inner = mobiusColors.at(source * 8 + channel);
+				float outer = mobiusColors.at(source * 8 + 4 + channel);
+				float nextInner = mobiusColors.at(next * 8 + (wraps ? 4 : 0) + channel);
+				float nextOuter = mobiusColors.at(next * 8 + (wraps ? 0 : 4) + channel);
+				float here = inner + (outer - inner) * across;
+				float there = nextInner + (nextOuter - nextInner) * across;
+				colors[j++] = here + (there - here) * blend;
+			}
 		}
 	}
-	//create triangle out of triangle-strip 
-	std::vector<int> sphereIndices2;
-	int i = 0;
+}
 
-	while (i < sphereIndices.size()) {
-		if (i == sphereIndices.size() - 2) {
-			break;
-		}
-		sphereIndices2.push_back(sphereIndices.at(i));
-		i++;
-		sphereIndices2.push_back(sphereIndices.at(i));
-		i++;
-		sphereIndices2.push_back(sphereIndices.at(i));
-		i--;
-	}
-	//correct rotation of normalized vectors
-	i = 0;
-	int temp = 0;
-	while (i < sphereIndices2.size() - 3) {
-		i = i + 3;
-		temp = sphereIndices2.at(i);
-		sphereIndices2.at(i) = sphereIndices2.at(i + 1);
-		sphereIndices2.at(i + 1) = temp;
-		i = i + 3;
-	};
-	return sphereIndices2;
+std::vector<int> calculateSphereIndices() {
+	std::vector<int> sphereIndices(gridTriangleCount(stacks, slices) * 3);
+	fillGridTriangles(sphereIndices, stacks, slices);
+	return sphereIndices;
+}
+
+std::vector<int> calculateLightSphereIndices() {
+	std::vector<int> sphereIndices(gridTriangleCount(stacksLight, slicesLight) * 3);
+	fillGridTriangles(sphereIndices, stacksLight, slicesLight);
+	return sphereIndices;
 }
 
 
@@ -1236,16 +1984,36 @@ std::vector<float>calculateMobiusColors(int rootOfColors) {
 
 std::vector<float> GenerateSphereTexCoordinates()
 {
-	std::vector<float> TexCoord;
-	for (int i = 0; i <= stacks; i++)
+	std::vector<float> TexCoord(sphereVertexCount(stacks, slices) * 2);
+	fillSphereTexCoords(TexCoord, stacks, slices);
+	return TexCoord;
+}
+
+//input, camera and animation clock of one frame, no GL calls
+FramePacket readFrameInput(GLFWwindow *window)
+{
+	float currentFrame = glfwGetTime();
+	deltaTime = currentFrame - lastFrame;
+	lastFrame = currentFrame;
+
+	setAllocationPhase(PHASE_INPUT);
+	processInput(window);
+	setAllocationPhase(PHASE_SIMULATION);
+
+	FramePacket frame = FramePacket();
+	frame.view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+	frame.cameraPos = cameraPos;
+	frame.stripSurfaceType = stripSurfaceType;
+	animationFrames++;
+	frame.animationStep = animationFrames >= animationInterval;
+	if (frame.animationStep)
 	{
-		for (int j = 0; j <= slices; j++)
-		{
-			TexCoord.push_back((j*1.0f) / (slices*1.0f));
-			TexCoord.push_back(1.0f - (i*1.0f) / (stacks*1.0f));
-		}
+		animationFrames = 0;
 	}
-	return TexCoord;
+	//the viewport follows the framebuffer, read here since GL is not current on this thread
+	glfwGetFramebufferSize(window, &frame.framebufferWidth, &frame.framebufferHeight);
+	frame.quit = false;
+	return frame;
 }
 
 void processInput(GLFWwindow *window)
@@ -1277,6 +2045,15 @@ void processInput(GLFWwindow *window)
 	if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
 		yaw += 0.1f;
 
+	if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+		stripSurfaceType = SURFACE_MOBIUS;
+	if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+		stripSurfaceType = SURFACE_SPHERE;
+	if (glfwGetKey(window, GLFW_KEY_3) == GLFW_PRESS)
+		stripSurfaceType = SURFACE_TORUS;
+	if (glfwGetKey(window, GLFW_KEY_4) == GLFW_PRESS)
+		stripSurfaceType = SURFACE_KLEIN;
+
 
 	glm::vec3 front;
 	front.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
@@ -1333,84 +2110,20 @@ unsigned int loadCubemap(std::vector<std::string> faces)
 
 
 std::vector<float> calculateEarthNormals(std::vector<float> &sphereVertices) {
-	std::vector<float> earthNormals;
-	for (int i = 0; i < sphereVertices.size(); i += 3)
-	{
-		glm::vec3 direction = glm::vec3(sphereVertices[i], sphereVertices[i + 1], sphereVertices[i + 2]);
-		glm::vec3 normal = glm::normalize(direction);
-		earthNormals.push_back(normal.x);
-		earthNormals.push_back(normal.y);
-		earthNormals.push_back(normal.z);
-	}
+	std::vector<float> earthNormals(sphereVertices.size());
+	fillRadialNormals(earthNormals, sphereVertices);
 	return earthNormals;
 }
 
 std::vector<float>calculateMobiusNormals(std::vector<int> &mobiusIndices, std::vector<float> &mobiusVertices) {
-
-
+	//the triangles that close the strip across the twist face the other way, alignFaces turns them
+	//around instead of patching the last vertex. The list is wound against the lighting, hence the minus
 	std::vector<float> mobiusNormals(mobiusVertices.size());
-
-	int i = 0;
-	while (i < mobiusIndices.size()) {
-		int triangle1 = mobiusIndices.at(i);
-		int triangle2 = mobiusIndices.at(i + 1);
-		int triangle3 = mobiusIndices.at(i + 2);
-
-
-		float x1 = mobiusVertices.at(triangle2 * 3) - mobiusVertices.at(triangle1 * 3);
-		float y1 = mobiusVertices.at(triangle2 * 3 + 1) - mobiusVertices.at(triangle1 * 3 + 1);
-		float z1 = mobiusVertices.at(triangle2 * 3 + 2) - mobiusVertices.at(triangle1 * 3 + 2);
-		float x2 = mobiusVertices.at(triangle3 * 3) - mobiusVertices.at(triangle1 * 3);
-		float y2 = mobiusVertices.at(triangle3 * 3 + 1) - mobiusVertices.at(triangle1 * 3 + 1);
-		float z2 = mobiusVertices.at(triangle3 * 3 + 2) - mobiusVertices.at(triangle1 * 3 + 2);
-		glm::vec3 b = glm::vec3(x1, y1, z1);
-		glm::vec3 c = glm::vec3(x2, y2, z2);
-		//Kreuzprodukt
-		glm::vec3 normal = glm::cross(b, c);
-		//Einheitsvektor
-		mobiusNormals[triangle1 * 3] -= normal.x;
-		mobiusNormals[triangle1 * 3 + 1] -= normal.y;
-		mobiusNormals[triangle1 * 3 + 2] -= normal.z;
-
-
-		x1 = mobiusVertices.at(triangle3 * 3) - mobiusVertices.at(triangle2 * 3);
-		y1 = mobiusVertices.at(triangle3 * 3 + 1) - mobiusVertices.at(triangle2 * 3 + 1);
-		z1 = mobiusVertices.at(triangle3 * 3 + 2) - mobiusVertices.at(triangle2 * 3 + 2);
-		x2 = mobiusVertices.at(triangle1 * 3) - mobiusVertices.at(triangle2 * 3);
-		y2 = mobiusVertices.at(triangle1 * 3 + 1) - mobiusVertices.at(triangle2 * 3 + 1);
-		z2 = mobiusVertices.at(triangle1 * 3 + 2) - mobiusVertices.at(triangle2 * 3 + 2);
-		b = glm::vec3(x1, y1, z1);
-		c = glm::vec3(x2, y2, z2);
-		//Kreuzprodukt
-		normal = glm::cross(b, c);
-		//Einheitsvektor
-		mobiusNormals[triangle2 * 3] -= normal.x;
-		mobiusNormals[triangle2 * 3 + 1] -= normal.y;
-		mobiusNormals[triangle2 * 3 + 2] -= normal.z;
-
-		x1 = mobiusVertices.at(triangle1 * 3) - mobiusVertices.at(triangle3 * 3);
-		y1 = mobiusVertices.at(triangle1 * 3 + 1) - mobiusVertices.at(triangle3 * 3 + 1);
-		z1 = mobiusVertices.at(triangle1 * 3 + 2) - mobiusVertices.at(triangle3 * 3 + 2);
-		x2 = mobiusVertices.at(triangle2 * 3) - mobiusVertices.at(triangle3 * 3);
-		y2 = mobiusVertices.at(triangle2 * 3 + 1) - mobiusVertices.at(triangle3 * 3 + 1);
-		z2 = mobiusVertices.at(triangle2 * 3 + 2) - mobiusVertices.at(triangle3 * 3 + 2);
-		b = glm::vec3(x1, y1, z1);
-		c = glm::vec3(x2, y2, z2);
-		//Kreuzprodukt
-		normal = glm::cross(b, c);
-		//Einheitsvektor
-		mobiusNormals[triangle3 * 3] -= normal.x;
-		mobiusNormals[triangle3 * 3 + 1] -= normal.y;
-		mobiusNormals[triangle3 * 3 + 2] -= normal.z;
-
-		i = i + 3;
-	}
-	for (int j = 0; j < mobiusNormals.size(); j += 3) {
-		glm::vec3 newNormal = glm::normalize(glm::vec3(mobiusNormals[j], mobiusNormals[j + 1], mobiusNormals[j + 2]));
-		mobiusNormals[j] = newNormal.x;
-		mobiusNormals[j + 1] = newNormal.y;
-		mobiusNormals[j + 2] = newNormal.z;
+	VertexAdjacency adjacency = buildVertexAdjacency(mobiusVertices.size() / 3, mobiusIndices, mobiusVertices, 0.0f);
+	computeVertexNormals(mobiusNormals, mobiusVertices, mobiusIndices, adjacency, WEIGHT_AREA, true);
+	for (float& component : mobiusNormals)
+	{
+		component = -component;
 	}
-
 	return mobiusNormals;
 }
\ No newline at end of file
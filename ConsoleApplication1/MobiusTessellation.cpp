@@ -0,0 +1,252 @@
+#include "MobiusTessellation.h"
+
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+
+static const float tessellationPi = 3.14159265358979323846f;
+
+// samples per side when measuring a segment, bisection steps when searching the end of one
+static const int errorSamples = 4;
+static const int searchSteps = 20;
+
+glm::vec3 mobiusPoint(float a, float s)
+{
+	float r = 1.0f + s * cos(0.5f * a);
+	return glm::vec3(r * cos(a), r * sin(a), s * sin(0.5f * a));
+}
+
+static glm::vec3 mobiusNormal(float a, float s)
+{
+	float cosHalf = cos(0.5f * a);
+	float sinHalf = sin(0.5f * a);
+	float r = 1.0f + s * cosHalf;
+	glm::vec3 dA = glm::vec3(-r * sin(a) - 0.5f * s * sinHalf * cos(a), r * cos(a) - 0.5f * s * sinHalf * sin(a), 0.5f * s * cosHalf);
+	glm::vec3 dS = glm::vec3(cosHalf * cos(a), cosHalf * sin(a), sinHalf);
+	return glm::normalize(glm::cross(dA, dS));
+}
+
+std::vector<int> mobiusStripIndices(int segments, int rows)
+{
+	std::vector<int> indices(mobiusStripIndexCount(segments, rows));
+	fillMobiusStripIndices(indices, segments, rows);
+	return indices;
+}
+
+int mobiusStripIndexCount(int segments, int rows)
+{
+	return segments * (rows - 1) * 6;
+}
+
+void fillMobiusStripIndices(Span<int> indices, int segments, int rows)
+{
+	int j = 0;
+	for (int segment = 0; segment < segments; segment++)
+	{
+		for (int row = 0; row + 1 < rows; row++)
+		{
+			int inner = segment * rows + row;
+			int outer = inner + 1;
+			int nextInner = segment + 1 < segments ? inner + rows : rows - 1 - row;
+			int nextOuter = segment + 1 < segments ? inner + rows + 1 : rows - 2 - row;
+			indices[j++] = inner;
+			indices[j++] = outer;
+			indices[j++] = nextInner;
+			indices[j++] = nextInner;
+			indices[j++] = outer;
+			indices[j++] = nextOuter;
+		}
+	}
+}
+
+// Distance between the triangles of the segment from a0 to a1 and the strip. A point with (t, r)
+// in the unit square of one row lies on the strip at a0 + t (a1 - a0) and r between the row's edges,
+// the triangles are split along the diagonal from outer a0 to inner a1 like mobiusStripIndices.
+// At a1 = 2 pi mobiusPoint already returns the reversed rows of a = 0.
+static float segmentError(float a0, float a1, int rows, float width)
+{
+	float error = 0.0f;
+	for (int row = 0; row + 1 < rows; row++)
+	{
+		float s0 = -width + 2.0f * width * row / (rows - 1);
+		float s1 = -width + 2.0f * width * (row + 1) / (rows - 1);
+		glm::vec3 inner0 = mobiusPoint(a0, s0);
+		glm::vec3 outer0 = mobiusPoint(a0, s1);
+		glm::vec3 inner1 = mobiusPoint(a1, s0);
+		glm::vec3 outer1 = mobiusPoint(a1, s1);
+
+		for (int j = 0; j <= errorSamples; j++)
+		{
+			float t = (float)j / errorSamples;
+			for (int k = 0; k <= errorSamples; k++)
+			{
+				float r = (float)k / errorSamples;
+				glm::vec3 flat;
+				if (t + r <= 1.0f)
+				{
+					flat = inner0 + t * (inner1 - inner0) + r * (outer0 - inner0);
+				}
+				else
+				{
+					flat = outer1 + (1.0f - t) * (outer0 - outer1) + (1.0f - r) * (inner1 - outer1);
+				}
+				float distance = glm::length(mobiusPoint(a0 + t * (a1 - a0), s0 + r * (s1 - s0)) - flat);
+				if (distance > error)
+				{
+					error = distance;
+				}
+			}
+		}
+	}
+	return error;
+}
+
+// Walks along the strip and makes every segment as long as the tolerance allows, the end of each
+// one is found by bisection. Only the last segment up to 2 pi may come out shorter than needed.
+static std::vector<float> adaptiveParameters(int rows, float width, float tolerance)
+{
+	std::vector<float> parameters;
+	float end = 2.0f * tessellationPi;
+	float a = 0.0f;
+	while (true)
+	{
+		parameters.push_back(a);
+		if (segmentError(a, end, rows, width) <= tolerance)
+		{
+			break;
+		}
+		float low = a;
+		float high = end;
+		for (int step = 0; step < searchSteps; step++)
+		{
+			float middle = 0.5f * (low + high);
+			if (segmentError(a, middle, rows, width) <= tolerance)
+			{
+				low = middle;
+			}
+			else
+			{
+				high = middle;
+			}
+		}
+		// a tolerance below float precision would stall here, take the smallest step that still moves
+		a = low > a ? low : high;
+	}
+	return parameters;
+}
+
+MobiusTessellation tessellateMobius(const std::vector<float>& parameters, int rows, float width)
+{
+	MobiusTessellation tessellation;
+	tessellation.parameters = parameters;
+	tessellation.rows = rows;
+	for (float a : parameters)
+	{
+		for (int row = 0; row < rows; row++)
+		{
+			float s = -width + 2.0f * width * row / (rows - 1);
+			glm::vec3 position = mobiusPoint(a, s);
+			glm::vec3 normal = mobiusNormal(a, s);
+			tessellation.positions.insert(tessellation.positions.end(), { position.x, position.y, position.z });
+			tessellation.normals.insert(tessellation.normals.end(), { normal.x, normal.y, normal.z });
+		}
+	}
+	tessellation.indices = mobiusStripIndices((int)parameters.size(), rows);
+	return tessellation;
+}
+
+MobiusTessellation tessellateMobiusAdaptive(float width, float tolerance)
+{
+	std::vector<float> best;
+	int bestRows = 0;
+	int maxRows = 32;
+	for (int rows = 2; rows <= maxRows; rows++)
+	{
+		// every sample along a needs at least 4 segments, more rows cannot win any more
+		if (bestRows != 0 && 4 * (rows - 1) > (int)best.size() * (bestRows - 1))
+		{
+			break;
+		}
+		std::vector<float> parameters = adaptiveParameters(rows, width, tolerance);
+		if (bestRows == 0 || parameters.size() * (rows - 1) < best.size() * (bestRows - 1))
+		{
+			best = parameters;
+			bestRows = rows;
+		}
+	}
+	return tessellateMobius(best, bestRows, width);
+}
+
+float mobiusTessellationError(const std::vector<float>& parameters, int rows, float width)
+{
+	float error = 0.0f;
+	for (int j = 0; j < (int)parameters.size(); j++)
+	{
+		float a1 = j + 1 < (int)parameters.size() ? parameters[j + 1] : 2.0f * tessellationPi;
+		float segment = segmentError(parameters[j], a1, rows, width);
+		if (segment > error)
+		{
+			error = segment;
+		}
+	}
+	return error;
+}
+
+std::vector<float> uniformMobiusParameters(int segments, float step)
+{
+	std::vector<float> parameters(segments);
+	fillUniformMobiusParameters(parameters, step);
+	return parameters;
+}
+
+void fillUniformMobiusParameters(Span<float> parameters, float step)
+{
+	for (int segment = 0; segment < parameters.size; segment++)
+	{
+		parameters[segment] = segment * step;
+	}
+}
+
+// fewest uniform segments within tolerance, the error falls with the segment count
+static int uniformSegments(int rows, float width, float tolerance)
+{
+	int low = 4;
+	int high = 4;
+	while (mobiusTessellationError(uniformMobiusParameters(high, 2.0f * tessellationPi / high), rows, width) > tolerance)
+	{
+		low = high;
+		high *= 2;
+	}
+	while (low + 1 < high)
+	{
+		int middle = (low + high) / 2;
+		if (mobiusTessellationError(uniformMobiusParameters(middle, 2.0f * tessellationPi / middle), rows, width) > tolerance)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	return high;
+}
+
+void printTessellationReport(float width)
+{
+	char line[128];
+	std::vector<float> current = uniformMobiusParameters(32, 0.2f);
+	snprintf(line, sizeof(line), "uniform step 0.2, 2 rows: %d triangles, error %.4f", (int)current.size() * 2, mobiusTessellationError(current, 2, width));
+	std::cout << line << std::endl;
+
+	std::cout << "tolerance  adaptive triangles (rows)  uniform 2 rows  uniform same rows" << std::endl;
+	float tolerances[] = { 0.01f, 0.003f, 0.001f };
+	for (float tolerance : tolerances)
+	{
+		MobiusTessellation adaptive = tessellateMobiusAdaptive(width, tolerance);
+		int twoRows = uniformSegments(2, width, tolerance);
+		int sameRows = uniformSegments(adaptive.rows, width, tolerance);
+		snprintf(line, sizeof(line), "%9.4f  %8d (%2d)  %14d  %17d", tolerance, (int)adaptive.indices.size() / 3, adaptive.rows, twoRows * 2, sameRows * 2 * (adaptive.rows - 1));
+		std::cout << line << std::endl;
+	}
+}
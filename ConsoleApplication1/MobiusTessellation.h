@@ -0,0 +1,50 @@
+#ifndef MOBIUSTESSELLATION_H
+#define MOBIUSTESSELLATION_H
+
+#include <glm/glm.hpp>
+
+#include "Span.h"
+
+#include <vector>
+
+// Samples the Möbius strip along a, "rows" vertices from the inner to the outer edge per sample
+// like the mobius mesher (rows = 2 is calculateMobiusVertices). Every segment joins sample j to
+// sample j + 1, the last one joins back to the first with the rows reversed (the half twist).
+struct MobiusTessellation
+{
+	std::vector<float> parameters;  // a of every sample, ascending in [0, 2 pi)
+	int rows;
+	std::vector<float> positions;   // vec3, inner edge to outer edge per sample
+	std::vector<float> normals;     // vec3, analytic like the mobius mesher
+	std::vector<int> indices;       // two triangles per segment and row
+};
+
+// point of the strip with center circle radius 1, s in [-width, width] across it
+glm::vec3 mobiusPoint(float a, float s);
+
+// triangles of a closed strip with "segments" samples, in the vertex order above
+std::vector<int> mobiusStripIndices(int segments, int rows);
+int mobiusStripIndexCount(int segments, int rows);
+void fillMobiusStripIndices(Span<int> indices, int segments, int rows);
+
+MobiusTessellation tessellateMobius(const std::vector<float>& parameters, int rows, float width);
+
+// "segments" samples "step" apart from a = 0, like the mobius mesher
+std::vector<float> uniformMobiusParameters(int segments, float step);
+// the same into parameters.size samples
+void fillUniformMobiusParameters(Span<float> parameters, float step);
+
+// Places the samples along a so the triangles of every segment stay within tolerance of the
+// strip, each segment as long as that allows. The twist bends the strip differently along a,
+// so the samples end up denser where the triangles would cut through it and sparser where it
+// is nearly flat. Across the width the strip is twisted,
+// not bent, so that error only shrinks with more rows; the row count with the fewest triangles wins.
+MobiusTessellation tessellateMobiusAdaptive(float width, float tolerance);
+
+// largest distance between the triangles and the strip, sampled densely inside every segment
+float mobiusTessellationError(const std::vector<float>& parameters, int rows, float width);
+
+// adaptive sample counts against uniform steps for a few tolerances
+void printTessellationReport(float width);
+
+#endif //MOBIUSTESSELLATION_H
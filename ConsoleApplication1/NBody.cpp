@@ -0,0 +1,605 @@
+#include "NBody.h"
+#include "SimdOps.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdio.h>
+#include <thread>
+
+// bodies per octree leaf, the leaves are worked off with the vector kernel
+static const int leafSize = 16;
+// a cube is not split any further, so bodies on top of each other end the recursion
+static const int maxTreeDepth = 24;
+// nodes that can wait on the traversal stack: seven siblings per level plus the current one
+static const int maxStack = maxTreeDepth * 8 + 8;
+// groups of four targets per chunk of the force loop
+static const int directGrain = 8;
+static const int treeGrain = 64;
+// bodies per chunk of the kicks and drifts
+static const int integrateGrain = 16384;
+
+namespace
+{
+
+// one body at a time with the same steps
+struct ScalarOps : ScalarFloatOps
+{
+	static Float rsqrt(Float a) { return 1.0f / std::sqrt(a); }
+};
+
+#if SIMD_X86
+struct Sse2Ops : Sse2FloatOps
+{
+	// the 12 bit estimate plus one Newton step, about 22 bits and far cheaper than sqrt and div
+	static Float rsqrt(Float a)
+	{
+		__m128 y = _mm_rsqrt_ps(a);
+		__m128 half = _mm_mul_ps(_mm_set1_ps(0.5f), a);
+		return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half, _mm_mul_ps(y, y))));
+	}
+};
+typedef Sse2Ops VectorOps;
+#elif SIMD_ARM_NEON
+struct NeonOps : NeonFloatOps
+{
+	static Float rsqrt(Float a)
+	{
+		float32x4_t y = vrsqrteq_f32(a);
+		y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(a, y), y));
+		return vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(a, y), y));
+	}
+};
+typedef NeonOps VectorOps;
+#else
+typedef ScalarOps VectorOps;
+#endif
+
+}
+
+static_assert(VectorOps::lanes == 1 || VectorOps::lanes == 4, "bodies are padded to four");
+
+static int paddedCount(int count)
+{
+	return (count + 3) & ~3;
+}
+
+// Acceleration on Ops::lanes targets, accumulated in the caller's registers.
+template <typename Ops>
+struct Targets
+{
+	typename Ops::Float x, y, z;
+	typename Ops::Float ax, ay, az;
+	typename Ops::Float softening;
+};
+
+// one source for all targets at once; a target on top of the source gets nothing, the
+// distance is zero and the softening keeps the division finite
+template <typename Ops>
+static inline void attract(Targets<Ops>& targets, float x, float y, float z, float mass)
+{
+	typedef typename Ops::Float Float;
+	Float dx = Ops::sub(Ops::set(x), targets.x);
+	Float dy = Ops::sub(Ops::set(y), targets.y);
+	Float dz = Ops::sub(Ops::set(z), targets.z);
+	Float distance2 = Ops::add(Ops::add(Ops::mul(dx, dx), Ops::mul(dy, dy)), Ops::add(Ops::mul(dz, dz), targets.softening));
+	Float inverse = Ops::rsqrt(distance2);
+	Float strength = Ops::mul(Ops::set(mass), Ops::mul(inverse, Ops::mul(inverse, inverse)));
+	targets.ax = Ops::add(targets.ax, Ops::mul(strength, dx));
+	targets.ay = Ops::add(targets.ay, Ops::mul(strength, dy));
+	targets.az = Ops::add(targets.az, Ops::mul(strength, dz));
+}
+
+template <typename Ops>
+static Targets<Ops> loadTargets(const NBodySystem& system, int first)
+{
+	Targets<Ops> targets;
+	targets.x = Ops::load(&system.positionX[first]);
+	targets.y = Ops::load(&system.positionY[first]);
+	targets.z = Ops::load(&system.positionZ[first]);
+	targets.ax = Ops::set(0.0f);
+	targets.ay = Ops::set(0.0f);
+	targets.az = Ops::set(0.0f);
+	targets.softening = Ops::set(system.softening);
+	attract(targets, system.attractor.x, system.attractor.y, system.attractor.z, system.attractorMass);
+	return targets;
+}
+
+template <typename Ops>
+static void storeTargets(NBodySystem& system, int first, const Targets<Ops>& targets)
+{
+	typename Ops::Float gravity = Ops::set(system.gravity);
+	Ops::store(&system.accelerationX[first], Ops::mul(targets.ax, gravity));
+	Ops::store(&system.accelerationY[first], Ops::mul(targets.ay, gravity));
+	Ops::store(&system.accelerationZ[first], Ops::mul(targets.az, gravity));
+}
+
+template <typename Ops>
+static void directRange(NBodySystem& system, int begin, int end)
+{
+	int padded = (int)system.mass.size();
+	for (int first = begin; first < end; first += Ops::lanes)
+	{
+		Targets<Ops> targets = loadTargets<Ops>(system, first);
+		// the padding weighs nothing and may be summed along
+		for (int source = 0; source < padded; source++)
+		{
+			attract(targets, system.positionX[source], system.positionY[source], system.positionZ[source], system.mass[source]);
+		}
+		storeTargets(system, first, targets);
+	}
+}
+
+static int octantOf(const NBodySystem& system, int body, glm::vec3 center)
+{
+	return (system.positionX[body] >= center.x ? 1 : 0) | (system.positionY[body] >= center.y ? 2 : 0) | (system.positionZ[body] >= center.z ? 4 : 0);
+}
+
+// Splits [begin, end) of the tree order into up to eight octants around center and adds
+// them as children of node, then goes on with each of them.
+static void buildNode(NBodySystem& system, int node, glm::vec3 center, float size, int depth)
+{
+	int begin = system.nodes[node].begin;
+	int end = system.nodes[node].end;
+	if (end - begin <= leafSize || depth == maxTreeDepth)
+	{
+		return;
+	}
+
+	// counting sort by octant, through a copy of the range
+	int counts[8] = {};
+	for (int j = begin; j < end; j++)
+	{
+		int body = system.order[j];
+		system.sortScratch[j] = body;
+		counts[octantOf(system, body, center)]++;
+	}
+	int starts[8];
+	int next[8];
+	int childCount = 0;
+	for (int octant = 0, start = begin; octant < 8; octant++)
+	{
+		starts[octant] = start;
+		next[octant] = start;
+		start += counts[octant];
+		childCount += counts[octant] > 0 ? 1 : 0;
+	}
+	for (int j = begin; j < end; j++)
+	{
+		int body = system.sortScratch[j];
+		system.order[next[octantOf(system, body, center)]++] = body;
+	}
+
+	int firstChild = (int)system.nodes.size();
+	system.nodes[node].firstChild = firstChild;
+	system.nodes[node].childCount = childCount;
+	float half = size * 0.5f;
+	glm::vec3 centers[8];
+	for (int octant = 0; octant < 8; octant++)
+	{
+		if (counts[octant] == 0)
+		{
+			continue;
+		}
+		OctreeNode child = {};
+		child.size = half;
+		child.firstChild = -1;
+		child.begin = starts[octant];
+		child.end = starts[octant] + counts[octant];
+		system.nodes.push_back(child);
+		centers[octant] = center + glm::vec3(octant & 1 ? half : -half, octant & 2 ? half : -half, octant & 4 ? half : -half) * 0.5f;
+	}
+	for (int octant = 0, child = firstChild; octant < 8; octant++)
+	{
+		if (counts[octant] > 0)
+		{
+			buildNode(system, child++, centers[octant], half, depth + 1);
+		}
+	}
+}
+
+static void permute(std::vector<float>& values, const std::vector<int>& order, std::vector<float>& scratch, int count)
+{
+	for (int j = 0; j < count; j++)
+	{
+		scratch[j] = values[order[j]];
+	}
+	std::copy(scratch.begin(), scratch.begin() + count, values.begin());
+}
+
+// The octree of the current positions. The bodies are sorted into tree order, so every
+// node's bodies lie side by side and four neighbours in the arrays are close in space.
+static void buildTree(NBodySystem& system)
+{
+	int count = system.count;
+	glm::vec3 lower(system.positionX[0], system.positionY[0], system.positionZ[0]);
+	glm::vec3 upper = lower;
+	for (int body = 0; body < count; body++)
+	{
+		glm::vec3 position(system.positionX[body], system.positionY[body], system.positionZ[body]);
+		lower = glm::min(lower, position);
+		upper = glm::max(upper, position);
+	}
+	glm::vec3 extent = upper - lower;
+	float size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f));
+
+	system.order.resize(count);
+	system.sortScratch.resize(count);
+	for (int body = 0; body < count; body++)
+	{
+		system.order[body] = body;
+	}
+	system.nodes.clear();
+	OctreeNode root = {};
+	root.size = size;
+	root.firstChild = -1;
+	root.begin = 0;
+	root.end = count;
+	system.nodes.push_back(root);
+	buildNode(system, 0, (lower + upper) * 0.5f, size, 0);
+
+	std::vector<float>* fields[] = { &system.positionX, &system.positionY, &system.positionZ, &system.velocityX, &system.velocityY, &system.velocityZ, &system.mass };
+	for (std::vector<float>* field : fields)
+	{
+		permute(*field, system.order, system.scratch, count);
+	}
+
+	// children come after their parents, so backwards every child is done before its parent
+	for (int node = (int)system.nodes.size() - 1; node >= 0; node--)
+	{
+		OctreeNode& current = system.nodes[node];
+		float mass = 0.0f;
+		glm::vec3 moment(0.0f);
+		if (current.firstChild < 0)
+		{
+			for (int body = current.begin; body < current.end; body++)
+			{
+				mass += system.mass[body];
+				moment += glm::vec3(system.positionX[body], system.positionY[body], system.positionZ[body]) * system.mass[body];
+			}
+		}
+		else
+		{
+			for (int child = current.firstChild; child < current.firstChild + current.childCount; child++)
+			{
+				const OctreeNode& below = system.nodes[child];
+				mass += below.mass;
+				moment += glm::vec3(below.massX, below.massY, below.massZ) * below.mass;
+			}
+		}
+		glm::vec3 centerOfMass = mass > 0.0f ? moment / mass : glm::vec3(0.0f);
+		current.mass = mass;
+		current.massX = centerOfMass.x;
+		current.massY = centerOfMass.y;
+		current.massZ = centerOfMass.z;
+	}
+}
+
+// Four neighbours in tree order walk the tree together. A node is taken as a whole when it is
+// small enough seen from the nearest point of the group's bounding sphere, which holds for
+// every target of the group; otherwise its children are looked at, and leaves body by body.
+template <typename Ops>
+static void treeRange(NBodySystem& system, int begin, int end, float theta)
+{
+	for (int first = begin; first < end; first += Ops::lanes)
+	{
+		int last = std::min(first + Ops::lanes, system.count);
+		glm::vec3 center(0.0f);
+		for (int body = first; body < last; body++)
+		{
+			center += glm::vec3(system.positionX[body], system.positionY[body], system.positionZ[body]);
+		}
+		center /= (float)std::max(last - first, 1);
+		float radius = 0.0f;
+		for (int body = first; body < last; body++)
+		{
+			radius = std::max(radius, glm::length(glm::vec3(system.positionX[body], system.positionY[body], system.positionZ[body]) - center));
+		}
+
+		Targets<Ops> targets = loadTargets<Ops>(system, first);
+		int stack[maxStack];
+		int stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const OctreeNode& node = system.nodes[stack[--stackSize]];
+			if (node.mass == 0.0f)
+			{
+				continue;
+			}
+			float distance = glm::length(glm::vec3(node.massX, node.massY, node.massZ) - center) - radius;
+			if (distance > 0.0f && node.size < theta * distance)
+			{
+				attract(targets, node.massX, node.massY, node.massZ, node.mass);
+			}
+			else if (node.firstChild < 0)
+			{
+				for (int source = node.begin; source < node.end; source++)
+				{
+					attract(targets, system.positionX[source], system.positionY[source], system.positionZ[source], system.mass[source]);
+				}
+			}
+			else
+			{
+				for (int child = node.firstChild; child < node.firstChild + node.childCount; child++)
+				{
+					stack[stackSize++] = child;
+				}
+			}
+		}
+		storeTargets(system, first, targets);
+	}
+}
+
+static void computeAccelerations(NBodySystem& system, NBodySolver solver, float theta, ThreadPool& pool)
+{
+	int groups = (int)system.mass.size() / VectorOps::lanes;
+	if (solver == NBODY_BARNES_HUT)
+	{
+		buildTree(system);
+		parallelFor(pool, groups, treeGrain, [&](int begin, int end)
+		{
+			treeRange<VectorOps>(system, begin * VectorOps::lanes, end * VectorOps::lanes, theta);
+		});
+	}
+	else
+	{
+		parallelFor(pool, groups, directGrain, [&](int begin, int end)
+		{
+			directRange<VectorOps>(system, begin * VectorOps::lanes, end * VectorOps::lanes);
+		});
+	}
+	system.accelerated = true;
+}
+
+static void kick(NBodySystem& system, float timeStep, ThreadPool& pool)
+{
+	parallelFor(pool, (int)system.mass.size(), integrateGrain, [&](int begin, int end)
+	{
+		for (int body = begin; body < end; body++)
+		{
+			system.velocityX[body] += system.accelerationX[body] * timeStep;
+			system.velocityY[body] += system.accelerationY[body] * timeStep;
+			system.velocityZ[body] += system.accelerationZ[body] * timeStep;
+		}
+	});
+}
+
+static void drift(NBodySystem& system, float timeStep, ThreadPool& pool)
+{
+	parallelFor(pool, (int)system.mass.size(), integrateGrain, [&](int begin, int end)
+	{
+		for (int body = begin; body < end; body++)
+		{
+			system.positionX[body] += system.velocityX[body] * timeStep;
+			system.positionY[body] += system.velocityY[body] * timeStep;
+			system.positionZ[body] += system.velocityZ[body] * timeStep;
+		}
+	});
+}
+
+void stepNBody(NBodySystem& system, float timeStep, NBodySolver solver, float theta, ThreadPool& pool)
+{
+	if (system.count == 0)
+	{
+		return;
+	}
+	// the second half kick of the last step already left the accelerations of these positions
+	if (!system.accelerated)
+	{
+		computeAccelerations(system, solver, theta, pool);
+	}
+	kick(system, timeStep * 0.5f, pool);
+	drift(system, timeStep, pool);
+	computeAccelerations(system, solver, theta, pool);
+	kick(system, timeStep * 0.5f, pool);
+}
+
+NBodySystem createOrbitingBodies(int count, glm::vec3 attractor, float attractorMass, float bodyMass, float innerRadius, float outerRadius, glm::vec3 normal, unsigned int seed)
+{
+	NBodySystem system;
+	system.count = count;
+	int padded = paddedCount(count);
+	std::vector<float>* fields[] = { &system.positionX, &system.positionY, &system.positionZ, &system.velocityX, &system.velocityY, &system.velocityZ, &system.accelerationX, &system.accelerationY, &system.accelerationZ, &system.mass };
+	for (std::vector<float>* field : fields)
+	{
+		field->assign(padded, 0.0f);
+	}
+	system.scratch.resize(padded);
+	system.totalMass = bodyMass;
+	system.gravity = 1.0f;
+	// about a third of the mean spacing in the disc, so close passes bend instead of slingshot
+	// and a step small enough for the orbits resolves them as well
+	float spacing = std::sqrt((outerRadius * outerRadius - innerRadius * innerRadius) / std::max(count, 1));
+	system.softening = spacing * spacing * 0.1f;
+	system.attractor = attractor;
+	system.attractorMass = attractorMass;
+	system.accelerated = false;
+
+	glm::vec3 axis = glm::normalize(normal);
+	glm::vec3 u = glm::normalize(glm::cross(axis, std::abs(axis.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f)));
+	glm::vec3 v = glm::cross(axis, u);
+
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	float massSum = 0.0f;
+	for (int body = 0; body < count; body++)
+	{
+		system.mass[body] = 0.25f + uniform(random) * uniform(random) * 2.0f;
+		massSum += system.mass[body];
+	}
+	for (int body = 0; body < count; body++)
+	{
+		system.mass[body] *= bodyMass / massSum;
+	}
+	for (int body = 0; body < count; body++)
+	{
+		// uniform over the area of the ring
+		float t = uniform(random);
+		float radius = std::sqrt(innerRadius * innerRadius + t * (outerRadius * outerRadius - innerRadius * innerRadius));
+		float angle = uniform(random) * 6.2831853f;
+		float height = (uniform(random) - 0.5f) * 0.04f * radius;
+		glm::vec3 radial = u * std::cos(angle) + v * std::sin(angle);
+		glm::vec3 position = attractor + radial * radius + axis * height;
+		// circular speed for the attractor plus the disc inside the orbit
+		float enclosed = attractorMass + bodyMass * t;
+		glm::vec3 velocity = glm::cross(axis, radial) * std::sqrt(system.gravity * enclosed / radius);
+		system.positionX[body] = position.x;
+		system.positionY[body] = position.y;
+		system.positionZ[body] = position.z;
+		system.velocityX[body] = velocity.x;
+		system.velocityY[body] = velocity.y;
+		system.velocityZ[body] = velocity.z;
+	}
+	// the padding sits on the attractor and is never moved far, it weighs nothing
+	for (int body = count; body < padded; body++)
+	{
+		system.positionX[body] = attractor.x;
+		system.positionY[body] = attractor.y;
+		system.positionZ[body] = attractor.z;
+	}
+	return system;
+}
+
+void fillBodyInstances(Span<float> instances, const NBodySystem& system, float scale)
+{
+	float averageMass = system.totalMass / std::max(system.count, 1);
+	for (int body = 0; body < system.count; body++)
+	{
+		instances[body * 4] = system.positionX[body];
+		instances[body * 4 + 1] = system.positionY[body];
+		instances[body * 4 + 2] = system.positionZ[body];
+		instances[body * 4 + 3] = scale * std::cbrt(system.mass[body] / averageMass);
+	}
+}
+
+// bodies and attractor, kinetic plus potential, every pair once
+static double totalEnergy(const NBodySystem& system)
+{
+	double energy = 0.0;
+	for (int body = 0; body < system.count; body++)
+	{
+		double vx = system.velocityX[body], vy = system.velocityY[body], vz = system.velocityZ[body];
+		energy += 0.5 * system.mass[body] * (vx * vx + vy * vy + vz * vz);
+		glm::vec3 position(system.positionX[body], system.positionY[body], system.positionZ[body]);
+		glm::vec3 offset = system.attractor - position;
+		energy -= system.gravity * system.attractorMass * system.mass[body] / std::sqrt(glm::dot(offset, offset) + system.softening);
+		for (int other = body + 1; other < system.count; other++)
+		{
+			double dx = system.positionX[other] - system.positionX[body];
+			double dy = system.positionY[other] - system.positionY[body];
+			double dz = system.positionZ[other] - system.positionZ[body];
+			energy -= system.gravity * system.mass[body] * system.mass[other] / std::sqrt(dx * dx + dy * dy + dz * dz + system.softening);
+		}
+	}
+	return energy;
+}
+
+void printNBodyReport()
+{
+	const glm::vec3 normal(0.0f, 0.3f, 1.0f);
+	char line[160];
+
+	// how far the tree is off: the same positions through both solvers
+	{
+		NBodySystem direct = createOrbitingBodies(16384, glm::vec3(0.0f), 1.0f, 0.1f, 0.3f, 1.0f, normal, 1);
+		ThreadPool* pool = createThreadPool(0);
+		computeAccelerations(direct, NBODY_BARNES_HUT, 0.5f, *pool);
+		NBodySystem tree = direct;
+		// without the attractor, which the tree does not approximate
+		direct.attractorMass = 0.0f;
+		tree.attractorMass = 0.0f;
+		std::cout << "Barnes-Hut against direct summation, 16384 bodies, bodies' share of the force" << std::endl;
+		for (float theta : { 0.3f, 0.5f, 0.7f, 1.0f })
+		{
+			computeAccelerations(direct, NBODY_DIRECT, theta, *pool);
+			computeAccelerations(tree, NBODY_BARNES_HUT, theta, *pool);
+			double error = 0.0;
+			double magnitude = 0.0;
+			for (int body = 0; body < direct.count; body++)
+			{
+				glm::vec3 expected(direct.accelerationX[body], direct.accelerationY[body], direct.accelerationZ[body]);
+				glm::vec3 actual(tree.accelerationX[body], tree.accelerationY[body], tree.accelerationZ[body]);
+				error += glm::dot(actual - expected, actual - expected);
+				magnitude += glm::dot(expected, expected);
+			}
+			snprintf(line, sizeof(line), "theta %.1f: rms error %.3f%%", theta, 100.0 * std::sqrt(error / magnitude));
+			std::cout << line << std::endl;
+		}
+		destroyThreadPool(pool);
+	}
+
+	// leapfrog keeps the energy, a drift would show up here
+	{
+		NBodySystem system = createOrbitingBodies(1024, glm::vec3(0.0f), 1.0f, 0.1f, 0.3f, 1.0f, normal, 2);
+		ThreadPool* pool = createThreadPool(1);
+		double before = totalEnergy(system);
+		// a bit more than one orbit at the outer edge
+		for (int step = 0; step < 1000; step++)
+		{
+			stepNBody(system, 0.007f, NBODY_DIRECT, 0.5f, *pool);
+		}
+		snprintf(line, sizeof(line), "energy after 1000 leapfrog steps of 1024 bodies: %+.2e relative", (totalEnergy(system) - before) / std::abs(before));
+		std::cout << line << std::endl;
+		destroyThreadPool(pool);
+	}
+
+	std::vector<int> threadCounts;
+	int hardware = std::max((int)std::thread::hardware_concurrency(), 1);
+	for (int threads = 1; threads < hardware; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(hardware);
+
+	std::cout << "ms per step, direct / Barnes-Hut with theta 0.5" << std::endl;
+	std::string header = "bodies  ";
+	for (int threads : threadCounts)
+	{
+		snprintf(line, sizeof(line), "  %3d thread%s       ", threads, threads == 1 ? " " : "s");
+		header += line;
+	}
+	std::cout << header << std::endl;
+	for (int count : { 1024, 4096, 16384, 65536, 262144, 1048576 })
+	{
+		std::string row;
+		snprintf(line, sizeof(line), "%7d ", count);
+		row += line;
+		for (int threads : threadCounts)
+		{
+			ThreadPool* pool = createThreadPool(threads);
+			double times[2] = { -1.0, -1.0 };
+			for (int solver = 0; solver < 2; solver++)
+			{
+				// every pair of a quarter million bodies takes minutes
+				if (solver == NBODY_DIRECT && count > 65536)
+				{
+					continue;
+				}
+				NBodySystem system = createOrbitingBodies(count, glm::vec3(0.0f), 1.0f, 0.1f, 0.3f, 1.0f, normal, 3);
+				stepNBody(system, 0.001f, (NBodySolver)solver, 0.5f, *pool);
+				int steps = std::max(1, std::min(10, 4 * 16384 / count));
+				auto start = std::chrono::high_resolution_clock::now();
+				for (int step = 0; step < steps; step++)
+				{
+					stepNBody(system, 0.001f, (NBodySolver)solver, 0.5f, *pool);
+				}
+				times[solver] = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count() * 1e3 / steps;
+			}
+			if (times[NBODY_DIRECT] < 0.0)
+			{
+				snprintf(line, sizeof(line), "  %9s / %7.2f", "-", times[NBODY_BARNES_HUT]);
+			}
+			else
+			{
+				snprintf(line, sizeof(line), "  %9.2f / %7.2f", times[NBODY_DIRECT], times[NBODY_BARNES_HUT]);
+			}
+			row += line;
+			destroyThreadPool(pool);
+		}
+		std::cout << row << std::endl;
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef NBODY_H
+#define NBODY_H
+
+#include "Span.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+struct ThreadPool;
+
+// Many light bodies under their mutual gravity plus one fixed heavy attractor, stepped with
+// kick-drift-kick leapfrog. The scheme is symplectic, so orbits keep their energy over long
+// runs instead of spiralling in or out like with explicit Euler.
+// Bodies are one array per coordinate, padded to a multiple of four with massless bodies,
+// so the force kernels run over four bodies per SSE2/NEON instruction without a scalar tail.
+
+enum NBodySolver
+{
+	NBODY_DIRECT,      // every pair, O(n^2), exact up to the softening
+	NBODY_BARNES_HUT   // octree, distant nodes act through their centre of mass, O(n log n)
+};
+
+// A cube of the octree. Children are stored next to each other and bodies are sorted in tree
+// order, so a node's bodies are one range of the arrays.
+struct OctreeNode
+{
+	float massX, massY, massZ;  // centre of mass
+	float mass;
+	float size;                 // edge length of the cube
+	int firstChild;             // -1 for leaves
+	int childCount;
+	int begin, end;             // bodies of the node
+};
+
+struct NBodySystem
+{
+	int count;  // bodies, the arrays are padded beyond
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> velocityX, velocityY, velocityZ;
+	std::vector<float> accelerationX, accelerationY, accelerationZ;
+	std::vector<float> mass;
+	float totalMass;        // of the bodies, without the attractor
+	float gravity;
+	float softening;        // squared, added to every squared distance so close passes stay finite
+	glm::vec3 attractor;    // fixed position of the heavy body
+	float attractorMass;
+	bool accelerated;       // the accelerations belong to the current positions
+
+	// rebuilt in every step, kept to reuse their memory
+	std::vector<OctreeNode> nodes;
+	std::vector<int> order;          // body of every tree position
+	std::vector<int> sortScratch;
+	std::vector<float> scratch;      // one array at a time while the bodies are sorted
+};
+
+// count bodies on roughly circular orbits in a disc around attractor, between the two radii,
+// in the plane with the given normal. Their masses add up to bodyMass.
+NBodySystem createOrbitingBodies(int count, glm::vec3 attractor, float attractorMass, float bodyMass, float innerRadius, float outerRadius, glm::vec3 normal, unsigned int seed);
+
+// one leapfrog step. theta is the Barnes-Hut opening angle: a node of size s at distance d is
+// taken as a whole when s < theta d. The force loop is split over the pool.
+void stepNBody(NBodySystem& system, float timeStep, NBodySolver solver, float theta, ThreadPool& pool);
+
+// xyz and radius per body, as vec4 for the instance buffer. Radii grow with the cube root of
+// the mass, scale is the radius of a body of average mass.
+void fillBodyInstances(Span<float> instances, const NBodySystem& system, float scale);
+
+// milliseconds per step of both solvers by body count and number of threads, and how far the
+// Barnes-Hut accelerations are from the direct ones
+void printNBodyReport();
+
+#endif //NBODY_H
@@ -0,0 +1,175 @@
+#include "ParametricSurface.h"
+
+const GLchar* vertexParametricShaderSource =
+"#version 440 core\n"
+"layout(location = 0) in vec2 aUV;"
+""
+"out vec4 fragmentColor;"
+"out vec2 TexCoord;"
+"out vec3 normal;"
+"out vec3 fragPos;"
+""
+"layout(std430, binding = 3) readonly buffer Palette { vec4 palette[]; };"
+""
+"uniform mat4 view;"
+"uniform mat4 projection;"
+""
+"uniform int surface;"
+"uniform float twist;"
+"uniform float width;"
+"uniform float radius;"
+"uniform vec3 center;"
+"uniform float rotation;"
+"uniform int paletteOffset;"
+""
+"const float PI = 3.14159265359;"
+""
+"vec3 kleinBottle(vec2 uv)"
+"{"
+"	float u = uv.x * 2.0 * PI;"
+"	float v = uv.y * 2.0 * PI;"
+"	float r = radius + width * (cos(0.5 * u) * sin(v) - sin(0.5 * u) * sin(2.0 * v));"
+"	return vec3(r * cos(u), r * sin(u), width * (sin(0.5 * u) * sin(v) + cos(0.5 * u) * sin(2.0 * v)));"
+"}"
+""
+"void evaluateSurface(vec2 uv, out vec3 position, out vec3 n)"
+"{"
+"	if (surface == 0)"
+"	{"
+"		float a = uv.x * 2.0 * PI;"
+"		float s = mix(-width, width, uv.y);"
+"		float cosTwist = cos(0.5 * twist * a);"
+"		float sinTwist = sin(0.5 * twist * a);"
+"		float r = radius + s * cosTwist;"
+"		position = vec3(r * cos(a), r * sin(a), s * sinTwist);"
+"		vec3 dA = vec3(-r * sin(a) - 0.5 * twist * s * sinTwist * cos(a), r * cos(a) - 0.5 * twist * s * sinTwist * sin(a), 0.5 * twist * s * cosTwist);"
+"		vec3 dS = vec3(cosTwist * cos(a), cosTwist * sin(a), sinTwist);"
+"		n = normalize(cross(dA, dS));"
+"	}"
+"	else if (surface == 1)"
+"	{"
+"		float phi = uv.x * 2.0 * PI;"
+"		float theta = uv.y * PI;"
+"		n = vec3(cos(phi) * sin(theta), sin(phi) * sin(theta), cos(theta));"
+"		position = radius * n;"
+"	}"
+"	else if (surface == 2)"
+"	{"
+"		float u = uv.x * 2.0 * PI;"
+"		float v = uv.y * 2.0 * PI;"
+"		n = vec3(cos(v) * cos(u), cos(v) * sin(u), sin(v));"
+"		position = vec3(radius * cos(u), radius * sin(u), 0.0) + width * n;"
+"	}"
+"	else"
+"	{"
+		// no closed form worth writing down, central differences are cheap enough
+"		const float e = 0.001;"
+"		position = kleinBottle(uv);"
+"		vec3 dU = kleinBottle(uv + vec2(e, 0.0)) - kleinBottle(uv - vec2(e, 0.0));"
+"		vec3 dV = kleinBottle(uv + vec2(0.0, e)) - kleinBottle(uv - vec2(0.0, e));"
+"		n = normalize(cross(dU, dV));"
+"	}"
+"}"
+""
+"vec4 paletteColor(vec2 uv)"
+"{"
+"	if (paletteOffset < 0) return vec4(1.0);"
+"	int size = palette.length();"
+"	int columns = size / 2;"
+"	float p = uv.x * float(columns);"
+"	int first = int(floor(p));"
+"	int second = first + 1;"
+"	vec4 inner = mix(palette[(2 * first + paletteOffset) % size], palette[(2 * second + paletteOffset) % size], fract(p));"
+"	vec4 outer = mix(palette[(2 * first + 1 + paletteOffset) % size], palette[(2 * second + 1 + paletteOffset) % size], fract(p));"
+"	return mix(inner, outer, uv.y);"
+"}"
+""
+"void main()"
+"{"
+"	vec3 position;"
+"	vec3 n;"
+"	evaluateSurface(aUV, position, n);"
+""
+"	mat3 rotate = mat3(cos(rotation), sin(rotation), 0.0, -sin(rotation), cos(rotation), 0.0, 0.0, 0.0, 1.0);"
+"	position = center + rotate * position;"
+"	normal = rotate * n;"
+"	fragPos = position;"
+"	TexCoord = surface == 1 ? vec2(aUV.x, 1.0 - aUV.y) : aUV;"
+"	fragmentColor = paletteColor(aUV);"
+"	gl_Position = projection * view * vec4(position, 1.0);"
+"}";
+
+ParametricGrid createParametricGrid(int uSegments, int vSegments)
+{
+	std::vector<unsigned short> uv;
+	for (int i = 0; i <= uSegments; i++)
+	{
+		for (int j = 0; j <= vSegments; j++)
+		{
+			uv.push_back((unsigned short)(65535 * i / uSegments));
+			uv.push_back((unsigned short)(65535 * j / vSegments));
+		}
+	}
+
+	std::vector<unsigned int> indices;
+	for (int i = 0; i < uSegments; i++)
+	{
+		for (int j = 0; j < vSegments; j++)
+		{
+			unsigned int corner = i * (vSegments + 1) + j;
+			unsigned int nextColumn = corner + vSegments + 1;
+			indices.push_back(corner);
+			indices.push_back(nextColumn);
+			indices.push_back(corner + 1);
+			indices.push_back(corner + 1);
+			indices.push_back(nextColumn);
+			indices.push_back(nextColumn + 1);
+		}
+	}
+
+	ParametricGrid grid;
+	grid.indexCount = indices.size();
+
+	glGenVertexArrays(1, &grid.vao);
+	glBindVertexArray(grid.vao);
+
+	glGenBuffers(1, &grid.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, grid.vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(unsigned short) * uv.size(), &uv.front(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_TRUE, 0, (void*)0);
+
+	glGenBuffers(1, &grid.ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, grid.ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), &indices.front(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	return grid;
+}
+
+void drawParametricGrid(const ParametricGrid& grid)
+{
+	glBindVertexArray(grid.vao);
+	glDrawElements(GL_TRIANGLES, grid.indexCount, GL_UNSIGNED_INT, 0);
+}
+
+GLuint createPaletteBuffer(const std::vector<float>& colors)
+{
+	GLuint palette;
+	glGenBuffers(1, &palette);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, palette);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * colors.size(), &colors.front(), GL_STATIC_DRAW);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, palette);
+	return palette;
+}
+
+void setParametricSurface(unsigned int program, const ParametricSurface& surface)
+{
+	glUniform1i(glGetUniformLocation(program, "surface"), surface.type);
+	glUniform1f(glGetUniformLocation(program, "twist"), surface.twist);
+	glUniform1f(glGetUniformLocation(program, "width"), surface.width);
+	glUniform1f(glGetUniformLocation(program, "radius"), surface.radius);
+	glUniform3f(glGetUniformLocation(program, "center"), surface.center.x, surface.center.y, surface.center.z);
+	glUniform1f(glGetUniformLocation(program, "rotation"), surface.rotation);
+	glUniform1i(glGetUniformLocation(program, "paletteOffset"), surface.paletteOffset);
+}
@@ -0,0 +1,49 @@
+#ifndef PARAMETRICSURFACE_H
+#define PARAMETRICSURFACE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// vertex shader that evaluates the surface from a (u,v) grid, outputs the same varyings
+// as vertexTextureShaderSource so it links against every fragment shader in Mobius.cpp
+extern const GLchar* vertexParametricShaderSource;
+
+enum SurfaceType
+{
+	SURFACE_MOBIUS = 0,
+	SURFACE_SPHERE = 1,
+	SURFACE_TORUS = 2,
+	SURFACE_KLEIN = 3
+};
+
+struct ParametricSurface
+{
+	int type;
+	float twist;       // half twists of the strip, 1 = Möbius
+	float width;       // half width of the strip, tube radius of torus and Klein bottle
+	float radius;      // center circle of strip, torus and Klein bottle, radius of the sphere
+	glm::vec3 center;
+	float rotation;    // around the z axis, like RotateEarth
+	int paletteOffset; // shifts the palette colors along the strip, -1 = no palette
+};
+
+// (uSegments+1)*(vSegments+1) vertices, each a normalized unsigned short (u,v) pair = 4 bytes
+struct ParametricGrid
+{
+	GLuint vao;
+	GLuint vbo;
+	GLuint ebo;
+	int indexCount;
+};
+
+ParametricGrid createParametricGrid(int uSegments, int vSegments);
+void drawParametricGrid(const ParametricGrid& grid);
+
+// colors laid out like calculateMobiusColors: inner and outer edge color per column along the strip
+GLuint createPaletteBuffer(const std::vector<float>& colors);
+
+void setParametricSurface(unsigned int program, const ParametricSurface& surface);
+
+#endif //PARAMETRICSURFACE_H
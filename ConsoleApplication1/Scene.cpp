@@ -0,0 +1,502 @@
+#include "Scene.h"
+#include "SimdOps.h"
+#include "ThreadPool.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// entities per chunk when a level is split over the pool, a multiple of every lane width
+static const int updateGrain = 4096;
+
+template <typename T>
+static void insertAt(std::vector<T>& values, int index, T value)
+{
+	values.insert(values.begin() + index, value);
+}
+
+static int levelOf(const Scene& scene, int index)
+{
+	int level = 0;
+	while (scene.levelStart[level + 1] <= index)
+	{
+		level++;
+	}
+	return level;
+}
+
+int createEntity(Scene& scene, int parent, int mesh, int material, float boundsRadius)
+{
+	if (scene.levelStart.empty())
+	{
+		scene.levelStart.push_back(0);
+	}
+	int parentIndex = parent >= 0 ? scene.indexOf[parent] : -1;
+	int depth = parent >= 0 ? levelOf(scene, parentIndex) + 1 : 0;
+	if (depth == (int)scene.levelStart.size() - 1)
+	{
+		scene.levelStart.push_back(scene.levelStart.back());
+	}
+
+	// at the end of its level; appending level by level never moves anything
+	int index = scene.levelStart[depth + 1];
+	int handle = (int)scene.indexOf.size();
+	insertAt(scene.handleOf, index, handle);
+	insertAt(scene.parent, index, parentIndex);
+	insertAt(scene.positionX, index, 0.0f);
+	insertAt(scene.positionY, index, 0.0f);
+	insertAt(scene.positionZ, index, 0.0f);
+	insertAt(scene.rotationX, index, 0.0f);
+	insertAt(scene.rotationY, index, 0.0f);
+	insertAt(scene.rotationZ, index, 0.0f);
+	insertAt(scene.rotationW, index, 1.0f);
+	insertAt(scene.scale, index, 1.0f);
+	for (int element = 0; element < 12; element++)
+	{
+		insertAt(scene.world[element], index, element == 0 || element == 4 || element == 8 ? 1.0f : 0.0f);
+	}
+	insertAt(scene.worldScale, index, 1.0f);
+	insertAt(scene.boundsRadius, index, boundsRadius);
+	insertAt(scene.mesh, index, mesh);
+	insertAt(scene.material, index, material);
+	insertAt(scene.dirty, index, (unsigned char)1);
+	scene.anyDirty = true;
+
+	for (int level = depth + 1; level < (int)scene.levelStart.size(); level++)
+	{
+		scene.levelStart[level]++;
+	}
+	scene.indexOf.push_back(index);
+	// everything behind the new entity moved up by one, and so did the parents among it
+	for (int moved = index + 1; moved < (int)scene.parent.size(); moved++)
+	{
+		scene.indexOf[scene.handleOf[moved]] = moved;
+		if (scene.parent[moved] >= index)
+		{
+			scene.parent[moved]++;
+		}
+	}
+	return handle;
+}
+
+void reserveEntities(Scene& scene, int count)
+{
+	scene.indexOf.reserve(count);
+	scene.handleOf.reserve(count);
+	scene.parent.reserve(count);
+	std::vector<float>* fields[] = { &scene.positionX, &scene.positionY, &scene.positionZ, &scene.rotationX, &scene.rotationY, &scene.rotationZ, &scene.rotationW, &scene.scale, &scene.worldScale, &scene.boundsRadius };
+	for (std::vector<float>* field : fields)
+	{
+		field->reserve(count);
+	}
+	for (std::vector<float>& element : scene.world)
+	{
+		element.reserve(count);
+	}
+	scene.mesh.reserve(count);
+	scene.material.reserve(count);
+	scene.dirty.reserve(count);
+}
+
+int entityCount(const Scene& scene)
+{
+	return (int)scene.indexOf.size();
+}
+
+static void markDirty(Scene& scene, int index)
+{
+	scene.dirty[index] = 1;
+	scene.anyDirty = true;
+}
+
+void setLocalPosition(Scene& scene, int entity, glm::vec3 position)
+{
+	int index = scene.indexOf[entity];
+	scene.positionX[index] = position.x;
+	scene.positionY[index] = position.y;
+	scene.positionZ[index] = position.z;
+	markDirty(scene, index);
+}
+
+void setLocalRotation(Scene& scene, int entity, float angle, glm::vec3 axis)
+{
+	int index = scene.indexOf[entity];
+	glm::vec3 direction = glm::normalize(axis) * std::sin(angle * 0.5f);
+	scene.rotationX[index] = direction.x;
+	scene.rotationY[index] = direction.y;
+	scene.rotationZ[index] = direction.z;
+	scene.rotationW[index] = std::cos(angle * 0.5f);
+	markDirty(scene, index);
+}
+
+void setLocalScale(Scene& scene, int entity, float scale)
+{
+	int index = scene.indexOf[entity];
+	scene.scale[index] = scale;
+	markDirty(scene, index);
+}
+
+void setEntityMesh(Scene& scene, int entity, int mesh)
+{
+	scene.mesh[scene.indexOf[entity]] = mesh;
+}
+
+void setEntityMaterial(Scene& scene, int entity, int material)
+{
+	scene.material[scene.indexOf[entity]] = material;
+}
+
+int entityMesh(const Scene& scene, int entity)
+{
+	return scene.mesh[scene.indexOf[entity]];
+}
+
+int entityMaterial(const Scene& scene, int entity)
+{
+	return scene.material[scene.indexOf[entity]];
+}
+
+namespace
+{
+
+// one entity at a time with the same steps, finishes the ends of the levels
+struct ScalarOps : ScalarFloatOps
+{
+	static Float gather(const float* base, const int* indices) { return base[indices[0]]; }
+};
+
+#if SIMD_X86
+struct Sse2Ops : Sse2FloatOps
+{
+	static Float gather(const float* base, const int* indices) { return _mm_set_ps(base[indices[3]], base[indices[2]], base[indices[1]], base[indices[0]]); }
+};
+typedef Sse2Ops VectorOps;
+#elif SIMD_ARM_NEON
+struct NeonOps : NeonFloatOps
+{
+	static Float gather(const float* base, const int* indices)
+	{
+		float values[4] = { base[indices[0]], base[indices[1]], base[indices[2]], base[indices[3]] };
+		return vld1q_f32(values);
+	}
+};
+typedef NeonOps VectorOps;
+#else
+typedef ScalarOps VectorOps;
+#endif
+
+}
+
+// World transforms of the Ops::lanes entities from "first" on, all of one level. A batch
+// without a dirty entity or a dirty parent is left as it is.
+template <typename Ops>
+static void updateBatch(Scene& scene, int first, bool roots)
+{
+	typedef typename Ops::Float Float;
+
+	const int* parents = &scene.parent[first];
+	unsigned char* dirty = &scene.dirty[first];
+	bool sharedParent = true;
+	for (int lane = 1; lane < Ops::lanes; lane++)
+	{
+		sharedParent = sharedParent && parents[lane] == parents[0];
+	}
+	// the parent's level is done, its flag already includes everything above it
+	if (!roots && sharedParent)
+	{
+		if (scene.dirty[parents[0]])
+		{
+			memset(dirty, 1, Ops::lanes);
+		}
+	}
+	else if (!roots)
+	{
+		for (int lane = 0; lane < Ops::lanes; lane++)
+		{
+			dirty[lane] |= scene.dirty[parents[lane]];
+		}
+	}
+	// all lanes' flags at once, a clean batch is the common case when little moves
+	uint32_t flags = 0;
+	memcpy(&flags, dirty, Ops::lanes);
+	if (flags == 0)
+	{
+		return;
+	}
+
+	Float qx = Ops::load(&scene.rotationX[first]);
+	Float qy = Ops::load(&scene.rotationY[first]);
+	Float qz = Ops::load(&scene.rotationZ[first]);
+	Float qw = Ops::load(&scene.rotationW[first]);
+	Float s = Ops::load(&scene.scale[first]);
+
+	Float x2 = Ops::add(qx, qx);
+	Float y2 = Ops::add(qy, qy);
+	Float z2 = Ops::add(qz, qz);
+	Float xx = Ops::mul(qx, x2);
+	Float yy = Ops::mul(qy, y2);
+	Float zz = Ops::mul(qz, z2);
+	Float xy = Ops::mul(qx, y2);
+	Float xz = Ops::mul(qx, z2);
+	Float yz = Ops::mul(qy, z2);
+	Float wx = Ops::mul(qw, x2);
+	Float wy = Ops::mul(qw, y2);
+	Float wz = Ops::mul(qw, z2);
+	Float one = Ops::set(1.0f);
+
+	// rotation times scale, column major like the world matrices, then the translation
+	Float local[12];
+	local[0] = Ops::mul(Ops::sub(one, Ops::add(yy, zz)), s);
+	local[1] = Ops::mul(Ops::add(xy, wz), s);
+	local[2] = Ops::mul(Ops::sub(xz, wy), s);
+	local[3] = Ops::mul(Ops::sub(xy, wz), s);
+	local[4] = Ops::mul(Ops::sub(one, Ops::add(xx, zz)), s);
+	local[5] = Ops::mul(Ops::add(yz, wx), s);
+	local[6] = Ops::mul(Ops::add(xz, wy), s);
+	local[7] = Ops::mul(Ops::sub(yz, wx), s);
+	local[8] = Ops::mul(Ops::sub(one, Ops::add(xx, yy)), s);
+	local[9] = Ops::load(&scene.positionX[first]);
+	local[10] = Ops::load(&scene.positionY[first]);
+	local[11] = Ops::load(&scene.positionZ[first]);
+
+	if (roots)
+	{
+		for (int element = 0; element < 12; element++)
+		{
+			Ops::store(&scene.world[element][first], local[element]);
+		}
+		Ops::store(&scene.worldScale[first], s);
+		return;
+	}
+
+	// siblings are mostly created together, then one broadcast replaces the gathers
+	Float parentWorld[12];
+	for (int element = 0; element < 12; element++)
+	{
+		const float* values = scene.world[element].data();
+		parentWorld[element] = sharedParent ? Ops::set(values[parents[0]]) : Ops::gather(values, parents);
+	}
+	Float parentScale = sharedParent ? Ops::set(scene.worldScale[parents[0]]) : Ops::gather(scene.worldScale.data(), parents);
+
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			Float value = Ops::add(Ops::add(
+				Ops::mul(parentWorld[row], local[column * 3]),
+				Ops::mul(parentWorld[3 + row], local[column * 3 + 1])),
+				Ops::mul(parentWorld[6 + row], local[column * 3 + 2]));
+			if (column == 3)
+			{
+				value = Ops::add(value, parentWorld[9 + row]);
+			}
+			Ops::store(&scene.world[column * 3 + row][first], value);
+		}
+	}
+	Ops::store(&scene.worldScale[first], Ops::mul(parentScale, s));
+}
+
+static void updateRange(Scene& scene, int begin, int end, bool roots)
+{
+	int index = begin;
+	for (; index + VectorOps::lanes <= end; index += VectorOps::lanes)
+	{
+		updateBatch<VectorOps>(scene, index, roots);
+	}
+	for (; index < end; index++)
+	{
+		updateBatch<ScalarOps>(scene, index, roots);
+	}
+}
+
+void updateWorldTransforms(Scene& scene, ThreadPool* pool)
+{
+	if (!scene.anyDirty)
+	{
+		return;
+	}
+	for (int level = 0; level + 1 < (int)scene.levelStart.size(); level++)
+	{
+		int begin = scene.levelStart[level];
+		int end = scene.levelStart[level + 1];
+		bool roots = level == 0;
+		if (pool != nullptr && end - begin > updateGrain)
+		{
+			parallelFor(*pool, end - begin, updateGrain, [&](int chunkBegin, int chunkEnd)
+			{
+				updateRange(scene, begin + chunkBegin, begin + chunkEnd, roots);
+			});
+		}
+		else
+		{
+			updateRange(scene, begin, end, roots);
+		}
+	}
+	std::fill(scene.dirty.begin(), scene.dirty.end(), (unsigned char)0);
+	scene.anyDirty = false;
+}
+
+glm::mat4 worldMatrix(const Scene& scene, int entity)
+{
+	int index = scene.indexOf[entity];
+	glm::mat4 matrix(1.0f);
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			matrix[column][row] = scene.world[column * 3 + row][index];
+		}
+	}
+	return matrix;
+}
+
+glm::vec3 worldPosition(const Scene& scene, int entity)
+{
+	int index = scene.indexOf[entity];
+	return glm::vec3(scene.world[9][index], scene.world[10][index], scene.world[11][index]);
+}
+
+float worldBoundsRadius(const Scene& scene, int entity)
+{
+	int index = scene.indexOf[entity];
+	return scene.boundsRadius[index] * scene.worldScale[index];
+}
+
+void fillWorldVertices(Span<float> positions, Span<float> normals, Span<const float> localPositions, Span<const float> localNormals, const Scene& scene, int entity)
+{
+	glm::mat4 matrix = worldMatrix(scene, entity);
+	// the scale is uniform, so the matrix turns the normals once it is divided out again
+	float inverseScale = 1.0f / scene.worldScale[scene.indexOf[entity]];
+	for (int j = 0; j + 2 < localPositions.size; j += 3)
+	{
+		glm::vec4 position = matrix * glm::vec4(localPositions[j], localPositions[j + 1], localPositions[j + 2], 1.0f);
+		positions[j] = position.x;
+		positions[j + 1] = position.y;
+		positions[j + 2] = position.z;
+		if (!normals.empty())
+		{
+			glm::vec4 normal = matrix * glm::vec4(localNormals[j], localNormals[j + 1], localNormals[j + 2], 0.0f) * inverseScale;
+			normals[j] = normal.x;
+			normals[j + 1] = normal.y;
+			normals[j + 2] = normal.z;
+		}
+	}
+}
+
+void printSceneReport(ThreadPool& pool)
+{
+	// suns with planets with moons, like the demo's, about a million of them
+	const int suns = 1024;
+	const int planetsPerSun = 31;
+	const int moonsPerPlanet = 32;
+	Scene scene;
+	reserveEntities(scene, suns * (1 + planetsPerSun * (1 + moonsPerPlanet)));
+	std::vector<int> sunEntities;
+	std::vector<int> planetEntities;
+	for (int sun = 0; sun < suns; sun++)
+	{
+		sunEntities.push_back(createEntity(scene, -1, 0, 0, 1.0f));
+		setLocalPosition(scene, sunEntities.back(), glm::vec3((float)(sun % 32) * 100.0f, (float)(sun / 32) * 100.0f, 0.0f));
+	}
+	for (int sun : sunEntities)
+	{
+		for (int planet = 0; planet < planetsPerSun; planet++)
+		{
+			planetEntities.push_back(createEntity(scene, sun, 0, 0, 0.5f));
+			setLocalPosition(scene, planetEntities.back(), glm::vec3(2.0f + planet, 0.0f, 0.0f));
+		}
+	}
+	int moon = -1;
+	for (int planet : planetEntities)
+	{
+		for (int j = 0; j < moonsPerPlanet; j++)
+		{
+			moon = createEntity(scene, planet, 0, 0, 0.1f);
+			setLocalPosition(scene, moon, glm::vec3(0.6f + 0.05f * j, 0.0f, 0.0f));
+			setLocalScale(scene, moon, 0.25f);
+		}
+	}
+	updateWorldTransforms(scene, &pool);
+
+	// the entities that get a new rotation before every update
+	std::vector<int> everything(entityCount(scene));
+	for (int entity = 0; entity < entityCount(scene); entity++)
+	{
+		everything[entity] = entity;
+	}
+	std::vector<int> somePlanets;
+	for (int planet = 0; planet < (int)planetEntities.size(); planet += 100)
+	{
+		somePlanets.push_back(planetEntities[planet]);
+	}
+	struct Case
+	{
+		const char* name;
+		const std::vector<int>* moving;
+	} cases[] = { { "everything", &everything }, { "every sun", &sunEntities }, { "1% of planets", &somePlanets }, { "nothing", nullptr } };
+
+	char line[128];
+	snprintf(line, sizeof(line), "%d entities in 3 levels, ms per update", entityCount(scene));
+	std::cout << line << std::endl;
+	snprintf(line, sizeof(line), "moving           %8d thread  %5d threads", 1, threadPoolSize(pool));
+	std::cout << line << std::endl;
+	int repeats = 10;
+	float angle = 0.0f;
+	for (const Case& moving : cases)
+	{
+		double times[2];
+		for (int run = 0; run < 2; run++)
+		{
+			double seconds = 0.0;
+			for (int repeat = 0; repeat < repeats; repeat++)
+			{
+				angle += 0.01f;
+				if (moving.moving != nullptr)
+				{
+					for (int entity : *moving.moving)
+					{
+						setLocalRotation(scene, entity, angle, glm::vec3(0.0f, 0.0f, 1.0f));
+					}
+				}
+				auto start = std::chrono::high_resolution_clock::now();
+				updateWorldTransforms(scene, run == 0 ? nullptr : &pool);
+				seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+			}
+			times[run] = seconds * 1e3 / repeats;
+		}
+		snprintf(line, sizeof(line), "%-15s  %10.3f  %13.3f", moving.name, times[0], times[1]);
+		std::cout << line << std::endl;
+	}
+
+	// the last moon against the same chain multiplied out by glm
+	int chain[] = { sunEntities.back(), planetEntities.back(), moon };
+	float angles[] = { 0.3f, -1.1f, 2.0f };
+	glm::vec3 axes[] = { glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(0.2f, -1.0f, 0.5f) };
+	glm::mat4 expected(1.0f);
+	for (int j = 0; j < 3; j++)
+	{
+		setLocalRotation(scene, chain[j], angles[j], axes[j]);
+		int index = scene.indexOf[chain[j]];
+		glm::vec3 position(scene.positionX[index], scene.positionY[index], scene.positionZ[index]);
+		glm::mat4 local = glm::rotate(glm::translate(glm::mat4(1.0f), position), angles[j], axes[j]);
+		expected = expected * glm::scale(local, glm::vec3(scene.scale[index]));
+	}
+	updateWorldTransforms(scene, &pool);
+	glm::mat4 actual = worldMatrix(scene, moon);
+	float error = 0.0f;
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			error = std::max(error, std::abs(actual[column][row] - expected[column][row]));
+		}
+	}
+	snprintf(line, sizeof(line), "largest difference to glm: %.2e", error);
+	std::cout << line << std::endl;
+}
@@ -0,0 +1,74 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "Span.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+struct ThreadPool;
+
+// The objects of the demo as entities. An entity is a handle; its components are one array
+// per field, all indexed alike, so an update streams through exactly the fields it needs.
+// Local transforms are translation, rotation quaternion and uniform scale. World transforms
+// are 3x4 affine matrices, one array per element as well, and are recomputed four entities per
+// SSE2/NEON instruction.
+// The arrays are kept sorted by depth in the hierarchy, every parent sits in an earlier level
+// than its children. A level can therefore be updated in any order and split over threads once
+// the levels above it are done; handles stay valid when an insertion moves entities around.
+struct Scene
+{
+	std::vector<int> levelStart;  // first index of every depth level, the last entry is the entity count
+	std::vector<int> indexOf;     // array index of every handle
+	std::vector<int> handleOf;    // handle at every array index
+	std::vector<int> parent;      // array index of the parent, -1 for roots
+
+	std::vector<float> positionX, positionY, positionZ;
+	std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+	std::vector<float> scale;
+
+	// column major, world[column * 3 + row]; the last column is the world position
+	std::vector<float> world[12];
+	std::vector<float> worldScale;
+
+	std::vector<float> boundsRadius;  // bounding sphere around the entity's origin, before scaling
+	std::vector<int> mesh;            // handles of whoever draws the entity, e.g. MeshArena meshes
+	std::vector<int> material;
+
+	// local transform changed since the last update, the update passes it on to the children
+	std::vector<unsigned char> dirty;
+	bool anyDirty = false;
+};
+
+// parent is a handle or -1 for a root. The entity starts at its parent's origin.
+int createEntity(Scene& scene, int parent, int mesh, int material, float boundsRadius);
+void reserveEntities(Scene& scene, int count);
+int entityCount(const Scene& scene);
+
+void setLocalPosition(Scene& scene, int entity, glm::vec3 position);
+// angle in radians around axis, which does not need to be normalized
+void setLocalRotation(Scene& scene, int entity, float angle, glm::vec3 axis);
+void setLocalScale(Scene& scene, int entity, float scale);
+void setEntityMesh(Scene& scene, int entity, int mesh);
+void setEntityMaterial(Scene& scene, int entity, int material);
+int entityMesh(const Scene& scene, int entity);
+int entityMaterial(const Scene& scene, int entity);
+
+// World transforms of every dirty entity and of everything below it, the rest is skipped.
+// Levels with enough entities are split over the pool; nullptr keeps it on the calling thread.
+void updateWorldTransforms(Scene& scene, ThreadPool* pool = nullptr);
+
+// as of the last updateWorldTransforms
+glm::mat4 worldMatrix(const Scene& scene, int entity);
+glm::vec3 worldPosition(const Scene& scene, int entity);
+float worldBoundsRadius(const Scene& scene, int entity);
+
+// vec3 positions and normals of a mesh built around the entity's origin, moved to where the
+// entity is, for the paths that bake the transform into the vertices. Empty normals are skipped.
+void fillWorldVertices(Span<float> positions, Span<float> normals, Span<const float> localPositions, Span<const float> localNormals, const Scene& scene, int entity);
+
+// time to update about a million entities in three levels, for a few shares of them moving
+void printSceneReport(ThreadPool& pool);
+
+#endif //SCENE_H
@@ -0,0 +1,67 @@
+#include "Shader.h"
+
+#include <iostream>
+
+unsigned int compileShader(GLenum type, const GLchar* source)
+{
+	unsigned int shader;
+	shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	int  success;
+	char infoLog[512];
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+	if (!success)
+	{
+		glGetShaderInfoLog(shader, 512, NULL, infoLog);
+		const char* stage = type == GL_VERTEX_SHADER ? "VERTEX" : type == GL_FRAGMENT_SHADER ? "FRAGMENT" : "COMPUTE";
+		std::cout << "ERROR::SHADER::" << stage << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+	}
+	return shader;
+}
+
+static void checkLinkStatus(unsigned int program)
+{
+	int  success;
+	char infoLog[512];
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+	if (!success)
+	{
+		glGetProgramInfoLog(program, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+	}
+}
+
+unsigned int createShaderProgram(const GLchar* vertexSource, const GLchar* fragmentSource)
+{
+	unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+	unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+	unsigned int program;
+	program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+	checkLinkStatus(program);
+
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	return program;
+}
+
+unsigned int createComputeProgram(const GLchar* source)
+{
+	unsigned int computeShader = compileShader(GL_COMPUTE_SHADER, source);
+
+	unsigned int program;
+	program = glCreateProgram();
+	glAttachShader(program, computeShader);
+	glLinkProgram(program);
+	checkLinkStatus(program);
+
+	glDeleteShader(computeShader);
+	return program;
+}
@@ -0,0 +1,11 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <glad/glad.h>
+
+// compile and link helpers, errors are printed to the console like the shader setup in main()
+unsigned int compileShader(GLenum type, const GLchar* source);
+unsigned int createShaderProgram(const GLchar* vertexSource, const GLchar* fragmentSource);
+unsigned int createComputeProgram(const GLchar* source);
+
+#endif //SHADER_H
@@ -0,0 +1,75 @@
+#ifndef SIMDOPS_H
+#define SIMDOPS_H
+
+// The float lane operations the vector loops of Scene and NBody have in common. A loop is
+// written once as a template over an "Ops" struct; a file derives its own ops from these and
+// adds what only it needs, gathers or reciprocal square roots. SimdTrig has integer lanes as
+// well and keeps its own ops in SimdTrigKernel.h.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <emmintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64) || defined(_M_ARM)
+#define SIMD_ARM_NEON 1
+#include <arm_neon.h>
+#else
+#define SIMD_ARM_NEON 0
+#endif
+
+// Internal linkage on purpose, also for the structs the files derive: ops of the same name with
+// other members in two files would have their inline functions merged by the linker.
+namespace
+{
+
+// one element at a time with the same steps, finishes the ends of the vector loops
+struct ScalarFloatOps
+{
+	typedef float Float;
+	static const int lanes = 1;
+
+	static Float load(const float* p) { return *p; }
+	static void store(float* p, Float v) { *p = v; }
+	static Float set(float v) { return v; }
+	static Float add(Float a, Float b) { return a + b; }
+	static Float sub(Float a, Float b) { return a - b; }
+	static Float mul(Float a, Float b) { return a * b; }
+};
+
+#if SIMD_X86
+// SSE2 is part of every x64 CPU and of the x86 baseline of the compilers the project uses
+struct Sse2FloatOps
+{
+	typedef __m128 Float;
+	static const int lanes = 4;
+
+	static Float load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, Float v) { _mm_storeu_ps(p, v); }
+	static Float set(float v) { return _mm_set1_ps(v); }
+	static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+};
+#endif
+
+#if SIMD_ARM_NEON
+struct NeonFloatOps
+{
+	typedef float32x4_t Float;
+	static const int lanes = 4;
+
+	static Float load(const float* p) { return vld1q_f32(p); }
+	static void store(float* p, Float v) { vst1q_f32(p, v); }
+	static Float set(float v) { return vdupq_n_f32(v); }
+	static Float add(Float a, Float b) { return vaddq_f32(a, b); }
+	static Float sub(Float a, Float b) { return vsubq_f32(a, b); }
+	static Float mul(Float a, Float b) { return vmulq_f32(a, b); }
+};
+#endif
+
+}
+
+#endif //SIMDOPS_H
@@ -0,0 +1,249 @@
+#include "SimdTrigKernel.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdio.h>
+#include <vector>
+
+#if TRIG_X86
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if TRIG_ARM_NEON
+#include <arm_neon.h>
+#endif
+
+static void sinCosScalar(const float* angles, float* sines, float* cosines, int count, TrigAccuracy /*accuracy*/)
+{
+	for (int j = 0; j < count; j++)
+	{
+		sines[j] = std::sin(angles[j]);
+		cosines[j] = std::cos(angles[j]);
+	}
+}
+
+#if TRIG_X86
+// internal linkage like the ScalarOps of SimdTrigKernel.h, Scene and NBody have ops of the same names
+namespace
+{
+
+// SSE2 is part of every x64 CPU and of the x86 baseline of the compilers the project uses
+struct Sse2Ops
+{
+	typedef __m128 Float;
+	typedef __m128i Int;
+	static const int lanes = 4;
+
+	static Float load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, Float v) { _mm_storeu_ps(p, v); }
+	static Float set(float v) { return _mm_set1_ps(v); }
+	static Int setInt(int32_t v) { return _mm_set1_epi32(v); }
+	static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+	static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+	static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+	static Float bitAnd(Float a, Float b) { return _mm_and_ps(a, b); }
+	static Float bitXor(Float a, Float b) { return _mm_xor_ps(a, b); }
+	static Float select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static Int truncate(Float a) { return _mm_cvttps_epi32(a); }
+	static Float toFloat(Int a) { return _mm_cvtepi32_ps(a); }
+	static Int addInt(Int a, Int b) { return _mm_add_epi32(a, b); }
+	static Int subInt(Int a, Int b) { return _mm_sub_epi32(a, b); }
+	static Int andInt(Int a, Int b) { return _mm_and_si128(a, b); }
+	static Int andNotInt(Int a, Int b) { return _mm_andnot_si128(a, b); }
+	static Float equalZero(Int a) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a, _mm_setzero_si128())); }
+	static Float octantSign(Int a) { return _mm_castsi128_ps(_mm_slli_epi32(a, 29)); }
+};
+
+}
+
+static void sinCosSse2(const float* angles, float* sines, float* cosines, int count, TrigAccuracy accuracy)
+{
+	sinCosBatch<Sse2Ops>(angles, sines, cosines, count, accuracy);
+}
+
+// AVX2 needs the CPU to have it and the OS to save the ymm registers on a context switch
+static bool cpuHasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return osSavesYmm && (info[1] & (1 << 5)) != 0;
+#else
+	// checks the OS support as well
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#if TRIG_ARM_NEON
+namespace
+{
+
+struct NeonOps
+{
+	typedef float32x4_t Float;
+	typedef int32x4_t Int;
+	static const int lanes = 4;
+
+	static Float load(const float* p) { return vld1q_f32(p); }
+	static void store(float* p, Float v) { vst1q_f32(p, v); }
+	static Float set(float v) { return vdupq_n_f32(v); }
+	static Int setInt(int32_t v) { return vdupq_n_s32(v); }
+	static Float add(Float a, Float b) { return vaddq_f32(a, b); }
+	static Float sub(Float a, Float b) { return vsubq_f32(a, b); }
+	static Float mul(Float a, Float b) { return vmulq_f32(a, b); }
+	static Float bitAnd(Float a, Float b) { return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+	static Float bitXor(Float a, Float b) { return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b))); }
+	static Float select(Float mask, Float a, Float b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+	static Int truncate(Float a) { return vcvtq_s32_f32(a); }
+	static Float toFloat(Int a) { return vcvtq_f32_s32(a); }
+	static Int addInt(Int a, Int b) { return vaddq_s32(a, b); }
+	static Int subInt(Int a, Int b) { return vsubq_s32(a, b); }
+	static Int andInt(Int a, Int b) { return vandq_s32(a, b); }
+	static Int andNotInt(Int a, Int b) { return vbicq_s32(b, a); }
+	static Float equalZero(Int a) { return vreinterpretq_f32_u32(vceqq_s32(a, vdupq_n_s32(0))); }
+	static Float octantSign(Int a) { return vreinterpretq_f32_s32(vshlq_n_s32(a, 29)); }
+};
+
+}
+
+static void sinCosNeon(const float* angles, float* sines, float* cosines, int count, TrigAccuracy accuracy)
+{
+	sinCosBatch<NeonOps>(angles, sines, cosines, count, accuracy);
+}
+#endif
+
+static SinCosFunction backendFunction(TrigBackend backend)
+{
+	switch (backend)
+	{
+#if TRIG_X86
+	case TRIG_SSE2:
+		return sinCosSse2;
+	case TRIG_AVX2:
+		return cpuHasAvx2() ? sinCosAvx2 : nullptr;
+#endif
+#if TRIG_ARM_NEON
+	case TRIG_NEON:
+		return sinCosNeon;
+#endif
+	case TRIG_SCALAR:
+		return sinCosScalar;
+	default:
+		return nullptr;
+	}
+}
+
+TrigBackend detectTrigBackend()
+{
+	TrigBackend preferred[] = { TRIG_AVX2, TRIG_NEON, TRIG_SSE2 };
+	for (TrigBackend backend : preferred)
+	{
+		if (trigBackendAvailable(backend))
+		{
+			return backend;
+		}
+	}
+	return TRIG_SCALAR;
+}
+
+bool trigBackendAvailable(TrigBackend backend)
+{
+	return backendFunction(backend) != nullptr;
+}
+
+static TrigBackend activeBackend = detectTrigBackend();
+static SinCosFunction activeFunction = backendFunction(activeBackend);
+
+void setTrigBackend(TrigBackend backend)
+{
+	activeBackend = trigBackendAvailable(backend) ? backend : TRIG_SCALAR;
+	activeFunction = backendFunction(activeBackend);
+}
+
+TrigBackend currentTrigBackend()
+{
+	return activeBackend;
+}
+
+const char* trigBackendName(TrigBackend backend)
+{
+	switch (backend)
+	{
+	case TRIG_SSE2:
+		return "SSE2";
+	case TRIG_AVX2:
+		return "AVX2";
+	case TRIG_NEON:
+		return "NEON";
+	default:
+		return "scalar";
+	}
+}
+
+void sinCos(const float* angles, float* sines, float* cosines, int count, TrigAccuracy accuracy)
+{
+	activeFunction(angles, sines, cosines, count, accuracy);
+}
+
+void printTrigReport()
+{
+	// a few turns in both directions, more than the generators ever pass
+	const int count = 1 << 16;
+	std::vector<float> angles(count);
+	for (int j = 0; j < count; j++)
+	{
+		angles[j] = -8.0f * 3.14159265f + 16.0f * 3.14159265f * j / count;
+	}
+	std::vector<float> sines(count);
+	std::vector<float> cosines(count);
+
+	char line[128];
+	std::cout << "backend  accuracy  max error  ns per angle" << std::endl;
+	TrigBackend backends[] = { TRIG_SCALAR, TRIG_SSE2, TRIG_AVX2, TRIG_NEON };
+	TrigAccuracy accuracies[] = { TRIG_PRECISE, TRIG_FAST };
+	for (TrigBackend backend : backends)
+	{
+		SinCosFunction function = backendFunction(backend);
+		if (function == nullptr)
+		{
+			continue;
+		}
+		for (TrigAccuracy accuracy : accuracies)
+		{
+			// the scalar backend has no fast variant
+			if (backend == TRIG_SCALAR && accuracy == TRIG_FAST)
+			{
+				continue;
+			}
+			int repeats = 20;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int repeat = 0; repeat < repeats; repeat++)
+			{
+				function(&angles.front(), &sines.front(), &cosines.front(), count, accuracy);
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			double error = 0.0;
+			for (int j = 0; j < count; j++)
+			{
+				error = std::fmax(error, std::fabs(sines[j] - std::sin((double)angles[j])));
+				error = std::fmax(error, std::fabs(cosines[j] - std::cos((double)angles[j])));
+			}
+			snprintf(line, sizeof(line), "%-7s  %-8s  %9.2e  %12.2f", trigBackendName(backend), accuracy == TRIG_PRECISE ? "precise" : "fast", error, seconds * 1e9 / ((double)count * repeats));
+			std::cout << line << std::endl;
+		}
+	}
+	std::cout << "active: " << trigBackendName(activeBackend) << std::endl;
+}
@@ -0,0 +1,38 @@
+#ifndef SIMDTRIG_H
+#define SIMDTRIG_H
+
+// Sine and cosine of many angles at once for the CPU generators. The vector kernels reduce the
+// angle to [-pi/4, pi/4] and evaluate a polynomial in 4 (SSE2, NEON) or 8 (AVX2) lanes; the
+// scalar backend calls std::sin and std::cos and is the reference the others are measured against.
+// The backend is picked once from what the CPU supports and can be overridden, e.g. to compare.
+
+enum TrigAccuracy
+{
+	TRIG_PRECISE,  // within 2 ulp of float sin/cos for |angle| < 8192
+	TRIG_FAST      // shorter polynomials, about 3e-4 absolute, for meshes that are regenerated every frame
+};
+
+enum TrigBackend
+{
+	TRIG_SCALAR,
+	TRIG_SSE2,
+	TRIG_AVX2,
+	TRIG_NEON
+};
+
+// best backend this CPU and build can run
+TrigBackend detectTrigBackend();
+bool trigBackendAvailable(TrigBackend backend);
+// falls back to the scalar backend if the requested one is not available
+void setTrigBackend(TrigBackend backend);
+TrigBackend currentTrigBackend();
+const char* trigBackendName(TrigBackend backend);
+
+// sines[j] = sin(angles[j]), cosines[j] = cos(angles[j]) for j < count, with the current backend.
+// Counts that are not a multiple of the lane width are finished with the same polynomial in scalar code.
+void sinCos(const float* angles, float* sines, float* cosines, int count, TrigAccuracy accuracy = TRIG_PRECISE);
+
+// largest error against double precision and throughput of every available backend
+void printTrigReport();
+
+#endif //SIMDTRIG_H
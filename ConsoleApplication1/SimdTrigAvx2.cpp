@@ -0,0 +1,56 @@
+// The AVX2 backend of SimdTrig. Everything in this file may use AVX2 instructions, so it is
+// only ever called after SimdTrig.cpp has checked the CPU. MSVC accepts the intrinsics without
+// /arch:AVX2, GCC and clang are told per function below so the rest of the program stays SSE2.
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "SimdTrigKernel.h"
+
+struct Avx2Ops
+{
+	typedef __m256 Float;
+	typedef __m256i Int;
+	static const int lanes = 8;
+
+	static Float load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, Float v) { _mm256_storeu_ps(p, v); }
+	static Float set(float v) { return _mm256_set1_ps(v); }
+	static Int setInt(int32_t v) { return _mm256_set1_epi32(v); }
+	static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+	static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+	static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+	static Float bitAnd(Float a, Float b) { return _mm256_and_ps(a, b); }
+	static Float bitXor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+	static Float select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+	static Int truncate(Float a) { return _mm256_cvttps_epi32(a); }
+	static Float toFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+	static Int addInt(Int a, Int b) { return _mm256_add_epi32(a, b); }
+	static Int subInt(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+	static Int andInt(Int a, Int b) { return _mm256_and_si256(a, b); }
+	static Int andNotInt(Int a, Int b) { return _mm256_andnot_si256(a, b); }
+	static Float equalZero(Int a) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, _mm256_setzero_si256())); }
+	static Float octantSign(Int a) { return _mm256_castsi256_ps(_mm256_slli_epi32(a, 29)); }
+};
+
+void sinCosAvx2(const float* angles, float* sines, float* cosines, int count, TrigAccuracy accuracy)
+{
+	sinCosBatch<Avx2Ops>(angles, sines, cosines, count, accuracy);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
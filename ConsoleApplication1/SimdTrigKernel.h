@@ -0,0 +1,148 @@
+#ifndef SIMDTRIGKERNEL_H
+#define SIMDTRIGKERNEL_H
+
+#include "SimdTrig.h"
+
+#include <stdint.h>
+#include <string.h>
+
+// Shared by the backend translation units of SimdTrig, not meant to be included anywhere else.
+// The kernel is written once against an "Ops" struct of lane operations; every backend only
+// supplies those. The AVX2 instance lives in its own file, it is the one compiled for AVX2.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRIG_X86 1
+#else
+#define TRIG_X86 0
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64) || defined(_M_ARM)
+#define TRIG_ARM_NEON 1
+#else
+#define TRIG_ARM_NEON 0
+#endif
+
+typedef void (*SinCosFunction)(const float* angles, float* sines, float* cosines, int count, TrigAccuracy accuracy);
+
+// Internal linkage on purpose: the AVX2 file compiles these for AVX2, and if the linker merged
+// its copies with the SSE2 ones a CPU without AVX2 could end up running them.
+namespace
+{
+
+// one float at a time with the same steps as the vector lanes, finishes the ends of the batches
+struct ScalarOps
+{
+	typedef float Float;
+	typedef int32_t Int;
+	static const int lanes = 1;
+
+	static Float load(const float* p) { return *p; }
+	static void store(float* p, Float v) { *p = v; }
+	static Float set(float v) { return v; }
+	static Int setInt(int32_t v) { return v; }
+	static Float add(Float a, Float b) { return a + b; }
+	static Float sub(Float a, Float b) { return a - b; }
+	static Float mul(Float a, Float b) { return a * b; }
+	static Float bitAnd(Float a, Float b) { return fromBits(bits(a) & bits(b)); }
+	static Float bitXor(Float a, Float b) { return fromBits(bits(a) ^ bits(b)); }
+	// mask ? a : b, the mask is all ones or all zeros
+	static Float select(Float mask, Float a, Float b) { return fromBits((bits(mask) & bits(a)) | (~bits(mask) & bits(b))); }
+	static Int truncate(Float a) { return (Int)a; }
+	static Float toFloat(Int a) { return (Float)a; }
+	static Int addInt(Int a, Int b) { return a + b; }
+	static Int subInt(Int a, Int b) { return a - b; }
+	static Int andInt(Int a, Int b) { return a & b; }
+	static Int andNotInt(Int a, Int b) { return ~a & b; }
+	static Float equalZero(Int a) { return fromBits(a == 0 ? 0xFFFFFFFFu : 0u); }
+	// bit 2 of the octant moved into the float sign bit
+	static Float octantSign(Int a) { return fromBits((uint32_t)a << 29); }
+
+	static uint32_t bits(Float a) { uint32_t b; memcpy(&b, &a, sizeof(b)); return b; }
+	static Float fromBits(uint32_t b) { Float a; memcpy(&a, &b, sizeof(a)); return a; }
+};
+
+// Cephes style sincosf. The octant j of |x| picks whether the sine or the cosine polynomial
+// serves each result and flips the signs; the reduction subtracts j pi/4 in three parts so the
+// reduced angle keeps its precision for large arguments.
+template <typename Ops>
+inline void sinCosLanes(typename Ops::Float x, TrigAccuracy accuracy, typename Ops::Float& sine, typename Ops::Float& cosine)
+{
+	typedef typename Ops::Float Float;
+	typedef typename Ops::Int Int;
+
+	Float signBit = Ops::set(-0.0f);
+	Float sinSign = Ops::bitAnd(x, signBit);
+	x = Ops::bitXor(x, sinSign);
+
+	Int j = Ops::truncate(Ops::mul(x, Ops::set(1.27323954473516f)));
+	j = Ops::andInt(Ops::addInt(j, Ops::setInt(1)), Ops::setInt(~1));
+	Float y = Ops::toFloat(j);
+
+	sinSign = Ops::bitXor(sinSign, Ops::octantSign(Ops::andInt(j, Ops::setInt(4))));
+	Float cosSign = Ops::octantSign(Ops::andNotInt(Ops::subInt(j, Ops::setInt(2)), Ops::setInt(4)));
+	Float sinPolynomial = Ops::equalZero(Ops::andInt(j, Ops::setInt(2)));
+
+	Float z;
+	Float sinPart;
+	Float cosPart;
+	if (accuracy == TRIG_PRECISE)
+	{
+		x = Ops::sub(x, Ops::mul(y, Ops::set(0.78515625f)));
+		x = Ops::sub(x, Ops::mul(y, Ops::set(2.4187564849853515625e-4f)));
+		x = Ops::sub(x, Ops::mul(y, Ops::set(3.77489497744594108e-8f)));
+		z = Ops::mul(x, x);
+
+		cosPart = Ops::set(2.443315711809948e-5f);
+		cosPart = Ops::add(Ops::mul(cosPart, z), Ops::set(-1.388731625493765e-3f));
+		cosPart = Ops::add(Ops::mul(cosPart, z), Ops::set(4.166664568298827e-2f));
+		cosPart = Ops::mul(Ops::mul(cosPart, z), z);
+		cosPart = Ops::add(Ops::sub(cosPart, Ops::mul(z, Ops::set(0.5f))), Ops::set(1.0f));
+
+		sinPart = Ops::set(-1.9515295891e-4f);
+		sinPart = Ops::add(Ops::mul(sinPart, z), Ops::set(8.3321608736e-3f));
+		sinPart = Ops::add(Ops::mul(sinPart, z), Ops::set(-1.6666654611e-1f));
+		sinPart = Ops::add(Ops::mul(Ops::mul(sinPart, z), x), x);
+	}
+	else
+	{
+		x = Ops::sub(x, Ops::mul(y, Ops::set(0.785398163397448f)));
+		z = Ops::mul(x, x);
+
+		cosPart = Ops::add(Ops::mul(Ops::set(4.166664568298827e-2f), z), Ops::set(-0.5f));
+		cosPart = Ops::add(Ops::mul(cosPart, z), Ops::set(1.0f));
+
+		sinPart = Ops::add(Ops::mul(Ops::set(8.3321608736e-3f), z), Ops::set(-1.6666654611e-1f));
+		sinPart = Ops::add(Ops::mul(Ops::mul(sinPart, z), x), x);
+	}
+
+	sine = Ops::bitXor(Ops::select(sinPolynomial, sinPart, cosPart), sinSign);
+	cosine = Ops::bitXor(Ops::select(sinPolynomial, cosPart, sinPart), cosSign);
+}
+
+// full batches in Ops::lanes, the rest with ScalarOps
+template <typename Ops>
+inline void sinCosBatch(const float* angles, float* sines, float* cosines, int count, TrigAccuracy accuracy)
+{
+	int j = 0;
+	for (; j + Ops::lanes <= count; j += Ops::lanes)
+	{
+		typename Ops::Float sine;
+		typename Ops::Float cosine;
+		sinCosLanes<Ops>(Ops::load(angles + j), accuracy, sine, cosine);
+		Ops::store(sines + j, sine);
+		Ops::store(cosines + j, cosine);
+	}
+	for (; j < count; j++)
+	{
+		sinCosLanes<ScalarOps>(angles[j], accuracy, sines[j], cosines[j]);
+	}
+}
+
+}
+
+#if TRIG_X86
+// defined in SimdTrigAvx2.cpp
+void sinCosAvx2(const float* angles, float* sines, float* cosines, int count, TrigAccuracy accuracy);
+#endif
+
+#endif //SIMDTRIGKERNEL_H
@@ -0,0 +1,33 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <type_traits>
+#include <vector>
+
+// Pointer and length of storage owned by someone else: a vector, a static table or a mapped
+// GL buffer. The fill functions of the generators write through it, so the caller decides where
+// the data lands. A stand-in for std::span, which the project's C++14 toolset does not have.
+template <typename T>
+struct Span
+{
+	T* data;
+	int size;
+
+	Span() : data(nullptr), size(0) {}
+	Span(T* data, int size) : data(data), size(size) {}
+	template <typename Allocator>
+	Span(std::vector<typename std::remove_const<T>::type, Allocator>& vector) : data(vector.data()), size((int)vector.size()) {}
+	// only compiles for Span<const T>
+	template <typename Allocator>
+	Span(const std::vector<typename std::remove_const<T>::type, Allocator>& vector) : data(vector.data()), size((int)vector.size()) {}
+	// a Span<float> is also a Span<const float>
+	template <typename U, typename = typename std::enable_if<std::is_same<const U, T>::value>::type>
+	Span(Span<U> other) : data(other.data), size(other.size) {}
+
+	T& operator[](int j) const { return data[j]; }
+	T* begin() const { return data; }
+	T* end() const { return data + size; }
+	bool empty() const { return size == 0; }
+};
+
+#endif //SPAN_H
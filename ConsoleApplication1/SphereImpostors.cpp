@@ -0,0 +1,92 @@
+#include "SphereImpostors.h"
+#include "Shader.h"
+
+// a quad through the centre of the sphere, square to the view ray through the centre. The cone from
+// the camera touching the sphere is r d / sqrt(d^2 - r^2) wide there, so the quad covers the outline
+const GLchar* vertexImpostorShaderSource =
+"#version 440 core\n"
+"layout(std430, binding = 6) readonly buffer Spheres { vec4 spheres[]; };"
+""
+"out vec3 impostorPos;"
+"flat out vec4 impostorSphere;"
+""
+"uniform mat4 viewProjection;"
+"uniform vec3 cameraPos;"
+"uniform int firstSphere;"
+""
+"void main()"
+"{"
+"	vec4 sphere = spheres[firstSphere + gl_InstanceID];"
+"	vec3 toSphere = sphere.xyz - cameraPos;"
+"	float distance = length(toSphere);"
+"	vec3 forward = toSphere / distance;"
+"	vec3 right = normalize(cross(forward, abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));"
+"	vec3 up = cross(right, forward);"
+"	float halfSize = sphere.w * distance / sqrt(max(distance * distance - sphere.w * sphere.w, 1e-6));"
+"	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;"
+"	impostorPos = sphere.xyz + (right * corner.x + up * corner.y) * halfSize;"
+"	impostorSphere = sphere;"
+"	gl_Position = viewProjection * vec4(impostorPos, 1.0);"
+"}";
+
+SphereImpostors createSphereImpostors(int capacity)
+{
+	SphereImpostors impostors;
+	impostors.capacity = capacity;
+	glGenVertexArrays(1, &impostors.vao);
+	glGenBuffers(1, &impostors.buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, impostors.buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * 4 * capacity, nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return impostors;
+}
+
+unsigned int createImpostorProgram(const GLchar* fragmentSource)
+{
+	return createShaderProgram(vertexImpostorShaderSource, fragmentSource);
+}
+
+void setImpostorSpheres(SphereImpostors& impostors, Span<const float> spheres)
+{
+	int count = spheres.size / 4;
+	if (count > impostors.capacity)
+	{
+		count = impostors.capacity;
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, impostors.buffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float) * 4 * count, spheres.data);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void bindImpostorSpheres(const SphereImpostors& impostors)
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SPHERE_IMPOSTOR_BINDING, impostors.buffer);
+}
+
+void setImpostorCamera(unsigned int program, const glm::mat4& viewProjection, glm::vec3 cameraPos)
+{
+	glUniformMatrix4fv(glGetUniformLocation(program, "viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+	glUniform3f(glGetUniformLocation(program, "cameraPos"), cameraPos.x, cameraPos.y, cameraPos.z);
+}
+
+void setImpostorOrientation(unsigned int program, const glm::mat4& world)
+{
+	// world to the sphere's frame: the transposed rotation, with the scale taken out
+	glm::mat3 orientation;
+	for (int column = 0; column < 3; column++)
+	{
+		glm::vec3 axis = glm::normalize(glm::vec3(world[column]));
+		for (int row = 0; row < 3; row++)
+		{
+			orientation[row][column] = axis[row];
+		}
+	}
+	glUniformMatrix3fv(glGetUniformLocation(program, "orientation"), 1, GL_FALSE, &orientation[0][0]);
+}
+
+void drawSphereImpostors(const SphereImpostors& impostors, unsigned int program, int first, int count)
+{
+	glUniform1i(glGetUniformLocation(program, "firstSphere"), first);
+	glBindVertexArray(impostors.vao);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+}
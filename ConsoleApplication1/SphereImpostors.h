@@ -0,0 +1,91 @@
+#ifndef SPHEREIMPOSTORS_H
+#define SPHEREIMPOSTORS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "Span.h"
+
+// Spheres without a mesh. Every sphere is one quad of 4 vertices facing the camera, just large
+// enough to cover the sphere's outline, and the fragment shader intersects the view ray with
+// the sphere itself: it discards the pixels beside it and writes the depth of the hit, so the
+// sphere is exactly round and cuts into other geometry correctly at any distance. Texture
+// coordinates come from the hit's direction in the sphere's own frame, laid out like
+// fillSphereTexCoords, so the earth, moon and sun textures fit the meshes' ones.
+// The spheres are vec4 (xyz centre, w radius) in a shader storage buffer at
+// SPHERE_IMPOSTOR_BINDING, the body instances of NBody.h already have that layout.
+#define SPHERE_IMPOSTOR_BINDING 6
+
+// fragment stage of an impostor program: the inputs of its vertex stage plus
+//   bool traceSphere(out vec3 fragPos, out vec3 normal, out vec2 texCoord)
+// which writes gl_FragDepth and returns false beside the sphere, and
+//   vec4 sampleSphere(sampler2D texture, vec2 texCoord)
+// which samples without the mip seam where the texture coordinates wrap around.
+// The fragment shader discards the misses only after sampling, the derivatives along the
+// outline need the neighbouring pixels. It declares its output and main itself.
+#define SPHERE_IMPOSTOR_GLSL \
+"in vec3 impostorPos;" \
+"flat in vec4 impostorSphere;" \
+"" \
+"uniform mat4 viewProjection;" \
+"uniform vec3 cameraPos;" \
+"uniform mat3 orientation;" \
+"" \
+"bool traceSphere(out vec3 fragPos, out vec3 normal, out vec2 texCoord)" \
+"{" \
+"	vec3 dir = normalize(impostorPos - cameraPos);" \
+"	vec3 fromCenter = cameraPos - impostorSphere.xyz;" \
+"	float b = dot(fromCenter, dir);" \
+"	float h = b * b - dot(fromCenter, fromCenter) + impostorSphere.w * impostorSphere.w;" \
+"	fragPos = cameraPos + dir * (-b - sqrt(max(h, 0.0)));" \
+"	normal = (fragPos - impostorSphere.xyz) / impostorSphere.w;" \
+"	vec4 clip = viewProjection * vec4(fragPos, 1.0);" \
+"	gl_FragDepth = (clip.z / clip.w) * 0.5 + 0.5;" \
+"	vec3 local = orientation * normal;" \
+"	texCoord = vec2(fract(atan(local.y, local.x) / 6.28318530718), 1.0 - acos(clamp(local.z, -1.0, 1.0)) / 3.14159265359);" \
+"	return h >= 0.0;" \
+"}" \
+"" \
+"vec4 sampleSphere(sampler2D sphereTexture, vec2 texCoord)" \
+"{" \
+"	vec2 dx = dFdx(texCoord);" \
+"	vec2 dy = dFdy(texCoord);" \
+"	float shiftedU = fract(texCoord.x + 0.5);" \
+"	float shiftedDx = dFdx(shiftedU);" \
+"	float shiftedDy = dFdy(shiftedU);" \
+"	if (abs(shiftedDx) + abs(shiftedDy) < abs(dx.x) + abs(dy.x))" \
+"	{" \
+"		dx.x = shiftedDx;" \
+"		dy.x = shiftedDy;" \
+"	}" \
+"	return textureGrad(sphereTexture, texCoord, dx, dy);" \
+"}"
+
+struct SphereImpostors
+{
+	GLuint vao;      // no attributes, the quad corners come from gl_VertexID
+	GLuint buffer;   // spheres that are not in a buffer of their own already
+	int capacity;
+};
+
+// room for capacity spheres set with setImpostorSpheres
+SphereImpostors createSphereImpostors(int capacity);
+
+// program of the impostor vertex stage and a fragment stage built on SPHERE_IMPOSTOR_GLSL
+unsigned int createImpostorProgram(const GLchar* fragmentSource);
+
+// 4 floats per sphere, at most capacity of them
+void setImpostorSpheres(SphereImpostors& impostors, Span<const float> spheres);
+void bindImpostorSpheres(const SphereImpostors& impostors);
+
+// the camera of the frame, on the program in use
+void setImpostorCamera(unsigned int program, const glm::mat4& viewProjection, glm::vec3 cameraPos);
+
+// the texture frame of a sphere whose mesh is drawn with world, on the program in use.
+// The spheres of one draw share it.
+void setImpostorOrientation(unsigned int program, const glm::mat4& world);
+
+// count spheres from first on of whatever buffer is bound at SPHERE_IMPOSTOR_BINDING
+void drawSphereImpostors(const SphereImpostors& impostors, unsigned int program, int first, int count);
+
+#endif //SPHEREIMPOSTORS_H
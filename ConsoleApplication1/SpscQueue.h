@@ -0,0 +1,99 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// Ring buffer for exactly one producer and one consumer thread. tryPush and tryPop never lock
+// or wait: each side writes only its own index, reads the other one's, and the
+// release/acquire pair on the index publishes the slot it guards. tryPush fails when the queue
+// is full and tryPop when it is empty. push and pop take the same lock-free path and only
+// when it fails sleep on a condition variable until the other side makes room or brings an
+// item, instead of spinning on a core; while nobody sleeps they never touch the mutex.
+template<typename T, int capacity>
+struct SpscQueue
+{
+	static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "the capacity has to be a power of two");
+
+	T slots[capacity];
+	// running counts, slot = count % capacity. Apart on their own cache lines, so pushing
+	// does not keep invalidating the line the consumer polls and the other way round.
+	alignas(64) std::atomic<unsigned> head{ 0 };  // popped so far, written by the consumer only
+	alignas(64) std::atomic<unsigned> tail{ 0 };  // pushed so far, written by the producer only
+
+	// only for a side that has to wait, at most one of them can: empty and full exclude each other
+	alignas(64) std::atomic<int> sleepers{ 0 };
+	std::mutex mutex;
+	std::condition_variable changed;
+};
+
+template<typename T, int capacity>
+bool tryPush(SpscQueue<T, capacity>& queue, const T& item)
+{
+	unsigned tail = queue.tail.load(std::memory_order_relaxed);
+	if (tail - queue.head.load(std::memory_order_acquire) == (unsigned)capacity)
+	{
+		return false;
+	}
+	queue.slots[tail % capacity] = item;
+	queue.tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+template<typename T, int capacity>
+bool tryPop(SpscQueue<T, capacity>& queue, T& item)
+{
+	unsigned head = queue.head.load(std::memory_order_relaxed);
+	if (head == queue.tail.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	item = queue.slots[head % capacity];
+	queue.head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+// Called after every successful push or pop. The fence orders the index store before the
+// sleepers load, and a sleeper counts itself before it checks the queue under the mutex, so
+// either the sleeper sees the change or this sees the sleeper.
+template<typename T, int capacity>
+void wakeSleeper(SpscQueue<T, capacity>& queue)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (queue.sleepers.load(std::memory_order_relaxed) > 0)
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.changed.notify_all();
+	}
+}
+
+// waits while the queue is full
+template<typename T, int capacity>
+void push(SpscQueue<T, capacity>& queue, const T& item)
+{
+	if (!tryPush(queue, item))
+	{
+		std::unique_lock<std::mutex> lock(queue.mutex);
+		queue.sleepers.fetch_add(1);
+		queue.changed.wait(lock, [&]() { return tryPush(queue, item); });
+		queue.sleepers.fetch_sub(1);
+	}
+	wakeSleeper(queue);
+}
+
+// waits while the queue is empty
+template<typename T, int capacity>
+void pop(SpscQueue<T, capacity>& queue, T& item)
+{
+	if (!tryPop(queue, item))
+	{
+		std::unique_lock<std::mutex> lock(queue.mutex);
+		queue.sleepers.fetch_add(1);
+		queue.changed.wait(lock, [&]() { return tryPop(queue, item); });
+		queue.sleepers.fetch_sub(1);
+	}
+	wakeSleeper(queue);
+}
+
+#endif //SPSCQUEUE_H
@@ -0,0 +1,66 @@
+#include "StreamBuffer.h"
+
+StreamBuffer createStreamBuffer(GLsizeiptr segmentSize, int segments)
+{
+	StreamBuffer stream;
+	GLint alignment = 1;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	stream.segmentSize = (segmentSize + alignment - 1) / alignment * alignment;
+	stream.fences.assign(segments, (GLsync)0);
+	stream.current = segments - 1;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &stream.buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, stream.buffer);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, stream.segmentSize * segments, nullptr, flags);
+	stream.mapped = (char*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stream.segmentSize * segments, flags);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return stream;
+}
+
+void destroyStreamBuffer(StreamBuffer& stream)
+{
+	for (GLsync fence : stream.fences)
+	{
+		if (fence != 0)
+		{
+			glDeleteSync(fence);
+		}
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, stream.buffer);
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glDeleteBuffers(1, &stream.buffer);
+	stream.buffer = 0;
+	stream.mapped = nullptr;
+}
+
+Span<float> nextStreamSegment(StreamBuffer& stream)
+{
+	stream.current = (stream.current + 1) % (int)stream.fences.size();
+	GLsync& fence = stream.fences[stream.current];
+	if (fence != 0)
+	{
+		// with as many segments as frames in flight this only waits when the GPU falls behind
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+		{
+		}
+		glDeleteSync(fence);
+		fence = 0;
+	}
+	if (stream.mapped == nullptr)
+	{
+		return Span<float>();
+	}
+	return Span<float>((float*)(stream.mapped + stream.segmentSize * stream.current), (int)(stream.segmentSize / sizeof(float)));
+}
+
+void bindStreamSegment(const StreamBuffer& stream, GLuint binding)
+{
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, stream.buffer, stream.segmentSize * stream.current, stream.segmentSize);
+}
+
+void fenceStreamSegment(StreamBuffer& stream)
+{
+	stream.fences[stream.current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
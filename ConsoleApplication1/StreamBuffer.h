@@ -0,0 +1,37 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <glad/glad.h>
+
+#include "Span.h"
+
+#include <vector>
+
+// Per-frame data the CPU writes and the GPU reads once, like instance positions. The buffer is
+// mapped once for its whole life (persistent and coherent) and split into segments that are
+// written in turn: the CPU fills the next segment while the GPU may still be drawing from the
+// others. Every segment gets a fence after its draws, and only a segment whose fence has
+// passed is handed out again, so nothing is ever written while the GPU reads it and no draw
+// waits on an orphaned buffer or a copy.
+struct StreamBuffer
+{
+	GLuint buffer;
+	GLsizeiptr segmentSize;   // bytes, rounded up to the storage buffer offset alignment
+	char* mapped;
+	std::vector<GLsync> fences;  // one per segment, 0 when it was never used
+	int current;
+};
+
+// segments = how many frames may be in flight at once
+StreamBuffer createStreamBuffer(GLsizeiptr segmentSize, int segments);
+void destroyStreamBuffer(StreamBuffer& stream);
+
+// Moves on to the next segment, waiting for the GPU if it is still reading it, and returns it
+// for writing. The returned memory goes straight to the GPU, so it is only ever written to.
+Span<float> nextStreamSegment(StreamBuffer& stream);
+// the current segment as shader storage buffer at binding
+void bindStreamSegment(const StreamBuffer& stream, GLuint binding);
+// after the last draw reading the current segment
+void fenceStreamSegment(StreamBuffer& stream);
+
+#endif //STREAMBUFFER_H
@@ -0,0 +1,182 @@
+#include "StripParticles.h"
+#include "Shader.h"
+
+#include <random>
+#include <vector>
+
+const GLchar* computeParticleShaderSource =
+"#version 440 core\n"
+"layout(local_size_x = 256) in;"
+""
+"layout(std430, binding = 7) buffer Particles { vec4 particles[]; };"
+"layout(std430, binding = 8) writeonly buffer Points { vec4 points[]; };"
+"layout(std430, binding = 9) buffer Command { uint vertexCount; uint instanceCount; uint first; uint baseInstance; };"
+""
+"uniform int count;"
+"uniform float timeStep;"
+"uniform float width;"
+"uniform float lift;"
+"uniform mat4 model;"
+"uniform mat4 viewProjection;"
+""
+"const float PI = 3.14159265359;"
+""
+"shared uint groupCount;"
+"shared uint groupBase;"
+""
+"void main()"
+"{"
+"	int id = int(gl_GlobalInvocationID.x);"
+"	bool visible = false;"
+"	vec4 point = vec4(0.0);"
+"	if (id < count)"
+"	{"
+"		vec4 particle = particles[id];"
+"		particle.x = mod(particle.x + particle.z * timeStep, 4.0 * PI);"
+"		particle.y += particle.w * timeStep;"
+		// bounces off the edges
+"		if (abs(particle.y) > width)"
+"		{"
+"			particle.y = sign(particle.y) * 2.0 * width - particle.y;"
+"			particle.w = -particle.w;"
+"		}"
+"		particles[id] = particle;"
+""
+		// the strip and its normal like the Möbius mesher, here for a beyond 2 pi as well
+"		float a = particle.x;"
+"		float s = particle.y;"
+"		float cosHalf = cos(0.5 * a);"
+"		float sinHalf = sin(0.5 * a);"
+"		float r = 1.0 + s * cosHalf;"
+"		vec3 position = vec3(r * cos(a), r * sin(a), s * sinHalf);"
+"		vec3 dA = vec3(-r * sin(a) - 0.5 * s * sinHalf * cos(a), r * cos(a) - 0.5 * s * sinHalf * sin(a), 0.5 * s * cosHalf);"
+"		vec3 dS = vec3(cosHalf * cos(a), cosHalf * sin(a), sinHalf);"
+"		vec3 n = normalize(cross(dA, dS));"
+"		vec4 world = model * vec4(position + lift * n, 1.0);"
+"		vec4 clip = viewProjection * world;"
+"		visible = all(lessThanEqual(abs(clip.xyz), vec3(clip.w)));"
+"		point = vec4(world.xyz, a < 2.0 * PI ? 0.0 : 1.0);"
+"	}"
+""
+	// one atomic on the command per group instead of one per particle
+"	if (gl_LocalInvocationIndex == 0) groupCount = 0u;"
+"	memoryBarrierShared();"
+"	barrier();"
+"	uint slot = 0u;"
+"	if (visible) slot = atomicAdd(groupCount, 1u);"
+"	memoryBarrierShared();"
+"	barrier();"
+"	if (gl_LocalInvocationIndex == 0) groupBase = atomicAdd(vertexCount, groupCount);"
+"	memoryBarrierShared();"
+"	barrier();"
+"	if (visible) points[groupBase + slot] = point;"
+"}";
+
+const GLchar* vertexParticleShaderSource =
+"#version 440 core\n"
+"layout(std430, binding = 8) readonly buffer Points { vec4 points[]; };"
+""
+"out vec3 color;"
+""
+"uniform mat4 viewProjection;"
+"uniform float pointScale;"
+""
+"void main()"
+"{"
+"	vec4 point = points[gl_VertexID];"
+"	gl_Position = viewProjection * vec4(point.xyz, 1.0);"
+"	gl_PointSize = max(pointScale / gl_Position.w, 1.0);"
+"	color = mix(vec3(1.0, 0.6, 0.15), vec3(0.2, 0.8, 1.0), point.w);"
+"}";
+
+const GLchar* fragmentParticleShaderSource =
+"#version 440 core\n"
+"out vec4 out_color;\n"
+""
+"in vec3 color;"
+""
+"void main()"
+"{"
+	// round sprites, a bit brighter in the middle like a lit ball
+"	vec2 offset = gl_PointCoord * 2.0 - 1.0;"
+"	float distance2 = dot(offset, offset);"
+"	if (distance2 > 1.0) discard;"
+"	out_color = vec4(color * (0.6 + 0.4 * sqrt(1.0 - distance2)), 1.0);"
+"}";
+
+// a fresh command for every update, nothing drawn until the compute shader counts
+static const GLuint emptyCommand[4] = { 0, 1, 0, 0 };
+
+StripParticles createStripParticles(int count, float width, unsigned int seed)
+{
+	StripParticles particles;
+	particles.count = count;
+	particles.width = width;
+	particles.updateProgram = createComputeProgram(computeParticleShaderSource);
+	particles.drawProgram = createShaderProgram(vertexParticleShaderSource, fragmentParticleShaderSource);
+
+	// spread over both laps, mostly along the strip and slowly across it
+	std::vector<float> state(count * 4);
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	for (int j = 0; j < count; j++)
+	{
+		state[j * 4] = uniform(random) * 4.0f * 3.14159265f;
+		state[j * 4 + 1] = (uniform(random) * 2.0f - 1.0f) * width;
+		state[j * 4 + 2] = 0.25f + 0.25f * uniform(random);
+		state[j * 4 + 3] = (uniform(random) * 2.0f - 1.0f) * 0.08f;
+	}
+
+	glGenBuffers(1, &particles.stateBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, particles.stateBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * state.size(), state.data(), GL_DYNAMIC_COPY);
+	glGenBuffers(1, &particles.pointBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, particles.pointBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * 4 * count, nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glGenBuffers(1, &particles.commandBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, particles.commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(emptyCommand), emptyCommand, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glGenVertexArrays(1, &particles.vao);
+	return particles;
+}
+
+void updateStripParticles(StripParticles& particles, float timeStep, float lift, const glm::mat4& model, const glm::mat4& viewProjection)
+{
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, particles.commandBuffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(emptyCommand), emptyCommand);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	unsigned int program = particles.updateProgram;
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "count"), particles.count);
+	glUniform1f(glGetUniformLocation(program, "timeStep"), timeStep);
+	glUniform1f(glGetUniformLocation(program, "width"), particles.width);
+	glUniform1f(glGetUniformLocation(program, "lift"), lift);
+	glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, &model[0][0]);
+	glUniformMatrix4fv(glGetUniformLocation(program, "viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, particles.stateBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, particles.pointBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, particles.commandBuffer);
+	glDispatchCompute((particles.count + 255) / 256, 1, 1);
+	// the points are read as storage by the draw, the count as its command
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void drawStripParticles(const StripParticles& particles, const glm::mat4& viewProjection, const glm::mat4& projection, float size, int viewportHeight)
+{
+	unsigned int program = particles.drawProgram;
+	glUseProgram(program);
+	glUniformMatrix4fv(glGetUniformLocation(program, "viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+	// size in pixels at distance 1, the shader divides by w
+	glUniform1f(glGetUniformLocation(program, "pointScale"), size * projection[1][1] * 0.5f * viewportHeight);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, particles.pointBuffer);
+
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	glBindVertexArray(particles.vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, particles.commandBuffer);
+	glDrawArraysIndirect(GL_POINTS, nullptr);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glDisable(GL_PROGRAM_POINT_SIZE);
+}
@@ -0,0 +1,39 @@
+#ifndef STRIPPARTICLES_H
+#define STRIPPARTICLES_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Particles that flow along the Möbius strip, entirely on the GPU. A particle is not a point in
+// space but a place on the strip: (a, s) in the parametrization of calculateMobiusVertices plus
+// its speed along both, so moving it costs the same anywhere and needs no mesh at all. The
+// update compute shader advances them, puts them on the surface (lifted a little along its
+// normal, so they ride on one face) and appends the ones in view to a point buffer. The draw is
+// one glDrawArraysIndirect over that buffer, with the count the compute shader left behind.
+// a runs over [0, 4 pi): the strip closes after 2 pi only with s turned around, so a particle
+// comes back to where it started on the opposite face after one lap and only after two on its
+// own face. Points are colored by the lap they are on, and the color flips where nothing but
+// the strip's single side separates them.
+struct StripParticles
+{
+	GLuint stateBuffer;     // vec4 per particle: a, s, speed along a, speed along s
+	GLuint pointBuffer;     // vec4 per visible particle: world position, lap
+	GLuint commandBuffer;   // DrawArraysIndirectCommand, the vertex count is written by the update
+	GLuint vao;             // no attributes, the point shader reads the points by gl_VertexID
+	unsigned int updateProgram;
+	unsigned int drawProgram;
+	int count;
+	float width;            // half width of the strip
+};
+
+// count particles spread evenly over a strip of half width "width"
+StripParticles createStripParticles(int count, float width, unsigned int seed);
+
+// moves every particle by timeStep and collects the ones inside the view of viewProjection,
+// model places the strip like the strip's own draw
+void updateStripParticles(StripParticles& particles, float timeStep, float lift, const glm::mat4& model, const glm::mat4& viewProjection);
+
+// point sprites of size world units, viewportHeight turns them into pixels
+void drawStripParticles(const StripParticles& particles, const glm::mat4& viewProjection, const glm::mat4& projection, float size, int viewportHeight);
+
+#endif //STRIPPARTICLES_H
@@ -0,0 +1,311 @@
+#include "ThreadPool.h"
+
+// which worker of which pool this thread is, so jobs spawned from a job go to its own deque
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+// own tasks come from the back, the most recently split and still warm in the cache
+static bool popTask(WorkQueue& queue, std::function<void()>& task)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.count == 0)
+	{
+		return false;
+	}
+	queue.count--;
+	task = std::move(queue.tasks[(queue.head + queue.count) % queue.tasks.size()]);
+	return true;
+}
+
+// stolen tasks come from the front, away from the owner
+static bool stealTask(WorkQueue& queue, std::function<void()>& task)
+{
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.count == 0)
+	{
+		return false;
+	}
+	task = std::move(queue.tasks[queue.head]);
+	queue.head = (queue.head + 1) % (int)queue.tasks.size();
+	queue.count--;
+	return true;
+}
+
+// own queue first (if any), then the others starting next to it
+static bool findTask(ThreadPool& pool, int self, std::function<void()>& task)
+{
+	int queueCount = (int)pool.queues.size();
+	if (self < queueCount && popTask(*pool.queues[self], task))
+	{
+		pool.queuedTasks--;
+		return true;
+	}
+	for (int j = 1; j <= queueCount; j++)
+	{
+		int victim = (self + j) % queueCount;
+		if (victim != self && stealTask(*pool.queues[victim], task))
+		{
+			pool.queuedTasks--;
+			return true;
+		}
+	}
+	return false;
+}
+
+// the queue of the calling thread, or the index past the workers' queues for any other thread
+static int ownQueue(ThreadPool& pool)
+{
+	return currentPool == &pool ? currentWorker : (int)pool.queues.size();
+}
+
+static void pushTask(ThreadPool& pool, int queue, std::function<void()> task)
+{
+	WorkQueue& target = *pool.queues[queue];
+	{
+		std::lock_guard<std::mutex> lock(target.mutex);
+		int capacity = (int)target.tasks.size();
+		if (target.count == capacity)
+		{
+			// full: unroll the ring into a twice as large one, the front at 0
+			std::vector<std::function<void()>> grown(capacity > 0 ? capacity * 2 : 64);
+			for (int j = 0; j < target.count; j++)
+			{
+				grown[j] = std::move(target.tasks[(target.head + j) % capacity]);
+			}
+			target.tasks.swap(grown);
+			target.head = 0;
+			capacity = (int)target.tasks.size();
+		}
+		target.tasks[(target.head + target.count) % capacity] = std::move(task);
+		target.count++;
+	}
+	pool.queuedTasks++;
+}
+
+static void wakeWorkers(ThreadPool& pool)
+{
+	{
+		// taking the lock orders the notify after a worker's check of queuedTasks
+		std::lock_guard<std::mutex> lock(pool.sleepMutex);
+	}
+	pool.wake.notify_all();
+}
+
+// after a range or a job is done, for the callers waiting on it
+static void wakeWaiters(ThreadPool& pool)
+{
+	// a waiter counts itself before it checks what it waits for, under the lock the notify takes
+	if (pool.waiting > 0)
+	{
+		wakeWorkers(pool);
+	}
+}
+
+// The caller runs tasks until the count is down to zero, a worker starting with its own queue;
+// tasks of other callers it picks up on the way are fine to run as well. With nothing left to
+// take it sleeps until a task is queued or the count drops to zero.
+static void helpUntilDone(ThreadPool& pool, const std::atomic<int>& unfinished)
+{
+	std::function<void()> task;
+	int self = ownQueue(pool);
+	while (unfinished > 0)
+	{
+		if (findTask(pool, self, task))
+		{
+			task();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(pool.sleepMutex);
+		pool.waiting++;
+		pool.wake.wait(lock, [&pool, &unfinished]() { return unfinished == 0 || pool.queuedTasks > 0; });
+		pool.waiting--;
+	}
+}
+
+static void workerLoop(ThreadPool* pool, int self)
+{
+	currentPool = pool;
+	currentWorker = self;
+	std::function<void()> task;
+	while (true)
+	{
+		if (findTask(*pool, self, task))
+		{
+			task();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(pool->sleepMutex);
+		pool->wake.wait(lock, [pool]() { return pool->stopping || pool->queuedTasks > 0; });
+		if (pool->stopping)
+		{
+			return;
+		}
+	}
+}
+
+ThreadPool* createThreadPool(int threads)
+{
+	if (threads <= 0)
+	{
+		threads = (int)std::thread::hardware_concurrency();
+	}
+	ThreadPool* pool = new ThreadPool();
+	pool->queuedTasks = 0;
+	pool->stopping = false;
+	pool->nextQueue = 0;
+	pool->waiting = 0;
+	for (int j = 0; j + 1 < threads; j++)
+	{
+		pool->queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+	}
+	for (int j = 0; j + 1 < threads; j++)
+	{
+		pool->workers.push_back(std::thread(workerLoop, pool, j));
+	}
+	return pool;
+}
+
+void destroyThreadPool(ThreadPool* pool)
+{
+	{
+		std::lock_guard<std::mutex> lock(pool->sleepMutex);
+		pool->stopping = true;
+	}
+	pool->wake.notify_all();
+	for (std::thread& worker : pool->workers)
+	{
+		worker.join();
+	}
+	delete pool;
+}
+
+int threadPoolSize(const ThreadPool& pool)
+{
+	return (int)pool.workers.size() + 1;
+}
+
+void parallelFor(ThreadPool& pool, int count, int grain, const std::function<void(int begin, int end)>& body)
+{
+	if (grain < 1)
+	{
+		grain = 1;
+	}
+	if (pool.workers.empty() || count <= grain)
+	{
+		body(0, count);
+		return;
+	}
+
+	// the chunks are dealt out round robin, stealing evens out what that gets wrong
+	std::atomic<int> remaining((count + grain - 1) / grain);
+	int queueCount = (int)pool.queues.size();
+	int queue = pool.nextQueue++ % queueCount;
+	// one pointer and two ints per chunk fit the inline storage of std::function, so queueing
+	// a chunk does not allocate
+	struct Range
+	{
+		const std::function<void(int begin, int end)>* body;
+		std::atomic<int>* remaining;
+		ThreadPool* pool;
+	} range = { &body, &remaining, &pool };
+	for (int begin = 0; begin < count; begin += grain)
+	{
+		int end = begin + grain < count ? begin + grain : count;
+		const Range* shared = &range;
+		pushTask(pool, queue, [shared, begin, end]()
+		{
+			(*shared->body)(begin, end);
+			// the range lives on the caller's stack and is gone once the last chunk is counted
+			ThreadPool* pool = shared->pool;
+			if (--(*shared->remaining) == 0)
+			{
+				wakeWaiters(*pool);
+			}
+		});
+		queue = (queue + 1) % queueCount;
+	}
+	wakeWorkers(pool);
+	helpUntilDone(pool, remaining);
+}
+
+static void finishJob(ThreadPool& pool, Job* job)
+{
+	// the parent is read before the count drops: once the root reaches zero the frame can be
+	// cleared under this thread's feet
+	bool done = false;
+	while (job != nullptr)
+	{
+		Job* parent = job->parent;
+		if (--job->unfinished != 0)
+		{
+			break;
+		}
+		done = true;
+		job = parent;
+	}
+	if (done)
+	{
+		wakeWaiters(pool);
+	}
+}
+
+Job* beginJobFrame(JobFrame& frame)
+{
+	resetLinearArena(frame.arena);
+	frame.root = nullptr;
+	frame.root = createJob(frame, nullptr, nullptr, nullptr);
+	return frame.root;
+}
+
+Job* createJob(JobFrame& frame, Job* parent, void (*run)(Job* job, void* work), void* work)
+{
+	if (parent == nullptr)
+	{
+		parent = frame.root;
+	}
+	// jobs create their children from any worker, the arena takes allocations from all of them
+	Job* job = new (arenaAllocate(frame.arena, sizeof(Job), alignof(Job))) Job();
+	job->run = run;
+	job->work = work;
+	job->parent = parent;
+	job->unfinished = 1;
+	if (parent != nullptr)
+	{
+		parent->unfinished++;
+	}
+	return job;
+}
+
+void runJob(ThreadPool& pool, Job* job)
+{
+	if (pool.workers.empty())
+	{
+		job->run(job, job->work);
+		finishJob(pool, job);
+		return;
+	}
+	int queue = ownQueue(pool);
+	if (queue == (int)pool.queues.size())
+	{
+		queue = pool.nextQueue++ % pool.queues.size();
+	}
+	ThreadPool* owner = &pool;
+	pushTask(pool, queue, [owner, job]()
+	{
+		job->run(job, job->work);
+		finishJob(*owner, job);
+	});
+	wakeWorkers(pool);
+}
+
+void waitJob(ThreadPool& pool, Job* job)
+{
+	helpUntilDone(pool, job->unfinished);
+}
+
+void endJobFrame(ThreadPool& pool, JobFrame& frame)
+{
+	// the root has no work of its own, only its own count to give up
+	finishJob(pool, frame.root);
+	waitJob(pool, frame.root);
+}
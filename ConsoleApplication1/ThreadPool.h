@@ -0,0 +1,97 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "FrameAllocator.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Worker threads with a task deque each. A worker takes its own tasks from the back and, once
+// it runs dry, steals from the front of the others, so uneven rows even out without a central
+// queue everyone contends on. The thread that calls parallelFor works along until its range is
+// done and sleeps when nothing is left to take.
+struct WorkQueue
+{
+	std::mutex mutex;
+	// A ring that only ever grows. A std::deque taken from the front and filled at the back frees
+	// and allocates its blocks all the time, so a frame splitting its loops would allocate.
+	std::vector<std::function<void()>> tasks;
+	int head = 0;   // the front task
+	int count = 0;
+};
+
+struct ThreadPool
+{
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkQueue>> queues;  // one per worker
+	std::atomic<int> queuedTasks;
+	std::atomic<bool> stopping;
+	std::atomic<unsigned> nextQueue;                 // round robin start for new ranges
+	std::atomic<int> waiting;                        // callers of parallelFor and waitJob asleep on wake
+	std::mutex sleepMutex;
+	std::condition_variable wake;                    // new tasks, a finished range or job, stopping
+};
+
+// threads = 0 takes one per hardware thread, the calling thread counts as one of them
+ThreadPool* createThreadPool(int threads = 0);
+void destroyThreadPool(ThreadPool* pool);
+// workers plus the calling thread
+int threadPoolSize(const ThreadPool& pool);
+
+// Runs body(begin, end) over [0, count) in chunks of "grain" and returns when all of them are
+// done. Chunks only decide who computes what: as long as every chunk writes its own part of
+// the output, the result is the same for any number of threads.
+void parallelFor(ThreadPool& pool, int count, int grain, const std::function<void(int begin, int end)>& body);
+
+// Jobs for the uneven work of a frame, on the same workers and deques as parallelFor. A job
+// counts itself plus its unfinished children; it is done when that drops to zero and then
+// takes itself off its parent, so waiting on a parent waits for the whole tree below it.
+struct Job
+{
+	void (*run)(Job* job, void* work);
+	void* work;  // the closure run is called with
+	Job* parent;
+	std::atomic<int> unfinished;
+};
+
+// The jobs of one frame under one root. Jobs and their closures are allocated from the frame's
+// arena and stay alive until the next beginJobFrame, so a child can always reach its parent
+// however late it runs, and a frame's jobs cost no heap allocation once the arena has grown.
+struct JobFrame
+{
+	LinearArena arena;
+	Job* root;
+};
+
+// Drops the last frame's jobs and starts a new root. Every job of the frame descends from it.
+Job* beginJobFrame(JobFrame& frame);
+// A job under parent (the frame root if nullptr). Children have to be created before their
+// parent finishes, from the parent's own work or before the parent is started.
+Job* createJob(JobFrame& frame, Job* parent, void (*run)(Job* job, void* work), void* work);
+
+// The same for a lambda or other callable taking the job itself, to create children under it.
+// It is copied into the frame's arena and never destroyed, so it may only capture what needs
+// no destructor: references, pointers and plain values.
+template<typename Work>
+Job* createJob(JobFrame& frame, Job* parent, const Work& work)
+{
+	static_assert(std::is_trivially_destructible<Work>::value, "job closures are dropped without running destructors");
+	Work* closure = new (arenaAllocate(frame.arena, sizeof(Work), alignof(Work))) Work(work);
+	return createJob(frame, parent, [](Job* job, void* data) { (*(Work*)data)(job); }, closure);
+}
+// Queues the job, on the own deque when called from a worker (a job spawning its children).
+// Without workers it runs right away.
+void runJob(ThreadPool& pool, Job* job);
+// Works on other tasks until the job and all of its children are done, sleeps while there are none.
+void waitJob(ThreadPool& pool, Job* job);
+// The frame barrier: returns once every job of the frame is done.
+void endJobFrame(ThreadPool& pool, JobFrame& frame);
+
+#endif //THREADPOOL_H
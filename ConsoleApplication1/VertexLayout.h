@@ -0,0 +1,201 @@
+#ifndef VERTEXLAYOUT_H
+#define VERTEXLAYOUT_H
+
+#include <glad/glad.h>
+
+#include "Span.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+// Compile-time description of an interleaved, quantized vertex. Every attribute format below
+// says how many floats it reads from its source stream, how it is stored and how the vertex
+// shader sees it. VertexLayout<...> puts them one after another, so
+//   typedef VertexLayout<PositionHalf, NormalPacked, ColorUnorm8> StripLayout;
+// gives a 16 byte StripLayout::Vertex, StripLayout::pack and StripLayout::createVertexArray.
+// Locations follow the arena VAO: 0 position, 1 color, 2 texcoord, 3 normal.
+
+// maps NaN to the lower bound instead of handing it to a float to int conversion
+inline float clampUnit(float value, float low)
+{
+	return value > 1.0f ? 1.0f : (value > low ? value : low);
+}
+
+inline GLushort floatToHalf(float value)
+{
+	GLuint bits;
+	memcpy(&bits, &value, sizeof(bits));
+	GLuint sign = (bits >> 16) & 0x8000;
+	int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+	GLuint mantissa = bits & 0x7fffff;
+
+	if (exponent <= 0)
+	{
+		// too small for a normal half, the geometry here never needs denormals
+		return (GLushort)sign;
+	}
+	if (exponent >= 31)
+	{
+		return (GLushort)(sign | 0x7c00);
+	}
+	// round to nearest, a carry out of the mantissa correctly bumps the exponent
+	return (GLushort)(sign | ((exponent << 10) + ((mantissa + 0x1000) >> 13)));
+}
+
+struct PositionHalf
+{
+	static const GLuint location = 0;
+	static const GLint size = 3;
+	static const GLenum type = GL_HALF_FLOAT;
+	static const GLboolean normalized = GL_FALSE;
+	static const int floats = 3;
+	struct Storage { GLushort value[4]; };  // padded to keep the next attribute 4 byte aligned
+
+	static void pack(Storage& storage, const float* source)
+	{
+		storage.value[0] = floatToHalf(source[0]);
+		storage.value[1] = floatToHalf(source[1]);
+		storage.value[2] = floatToHalf(source[2]);
+		storage.value[3] = 0;
+	}
+};
+
+struct NormalPacked
+{
+	static const GLuint location = 3;
+	static const GLint size = 4;
+	static const GLenum type = GL_INT_2_10_10_10_REV;
+	static const GLboolean normalized = GL_TRUE;
+	static const int floats = 3;
+	struct Storage { GLuint value; };
+
+	static GLuint packSnorm10(float value)
+	{
+		return (GLuint)(int)floor(clampUnit(value, -1.0f) * 511.0f + 0.5f) & 0x3ff;
+	}
+
+	static void pack(Storage& storage, const float* source)
+	{
+		storage.value = packSnorm10(source[0]) | (packSnorm10(source[1]) << 10) | (packSnorm10(source[2]) << 20);
+	}
+};
+
+struct ColorUnorm8
+{
+	static const GLuint location = 1;
+	static const GLint size = 4;
+	static const GLenum type = GL_UNSIGNED_BYTE;
+	static const GLboolean normalized = GL_TRUE;
+	static const int floats = 4;
+	struct Storage { GLubyte value[4]; };
+
+	static void pack(Storage& storage, const float* source)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			storage.value[j] = (GLubyte)(clampUnit(source[j], 0.0f) * 255.0f + 0.5f);
+		}
+	}
+};
+
+struct TexCoordUnorm16
+{
+	static const GLuint location = 2;
+	static const GLint size = 2;
+	static const GLenum type = GL_UNSIGNED_SHORT;
+	static const GLboolean normalized = GL_TRUE;
+	static const int floats = 2;
+	struct Storage { GLushort value[2]; };
+
+	static void pack(Storage& storage, const float* source)
+	{
+		storage.value[0] = (GLushort)(clampUnit(source[0], 0.0f) * 65535.0f + 0.5f);
+		storage.value[1] = (GLushort)(clampUnit(source[1], 0.0f) * 65535.0f + 0.5f);
+	}
+};
+
+// the interleaved vertex, one Storage per attribute in declaration order. The last attribute
+// has its own specialization so no empty member pads the end of the struct.
+template <typename... Attributes>
+struct PackedVertex;
+
+template <typename Attribute>
+struct PackedVertex<Attribute>
+{
+	typename Attribute::Storage value;
+
+	void pack(const float* const* sources, int vertex)
+	{
+		Attribute::pack(value, sources[0] + Attribute::floats * vertex);
+	}
+
+	static void setupFormat(GLuint bindingIndex, GLuint relativeOffset)
+	{
+		glEnableVertexAttribArray(Attribute::location);
+		glVertexAttribFormat(Attribute::location, Attribute::size, Attribute::type, Attribute::normalized, relativeOffset);
+		glVertexAttribBinding(Attribute::location, bindingIndex);
+	}
+};
+
+template <typename Attribute, typename Next, typename... Rest>
+struct PackedVertex<Attribute, Next, Rest...>
+{
+	typename Attribute::Storage value;
+	PackedVertex<Next, Rest...> rest;
+
+	void pack(const float* const* sources, int vertex)
+	{
+		Attribute::pack(value, sources[0] + Attribute::floats * vertex);
+		rest.pack(sources + 1, vertex);
+	}
+
+	static void setupFormat(GLuint bindingIndex, GLuint relativeOffset)
+	{
+		PackedVertex<Attribute>::setupFormat(bindingIndex, relativeOffset);
+		PackedVertex<Next, Rest...>::setupFormat(bindingIndex, relativeOffset + sizeof(typename Attribute::Storage));
+	}
+};
+
+template <typename... Attributes>
+struct VertexLayout
+{
+	typedef PackedVertex<Attributes...> Vertex;
+	static const GLsizei stride = sizeof(Vertex);
+
+	// one float stream per attribute, laid out like the calculate... generators in Mobius.cpp
+	template <typename... Streams>
+	static std::vector<Vertex> pack(int vertexCount, const Streams&... streams)
+	{
+		std::vector<Vertex> vertices(vertexCount);
+		packInto(vertices, streams...);
+		return vertices;
+	}
+
+	// the same into vertices.size vertices that already exist, to repack without allocating
+	template <typename... Streams>
+	static void packInto(Span<Vertex> vertices, const Streams&... streams)
+	{
+		static_assert(sizeof...(Streams) == sizeof...(Attributes), "one stream per attribute");
+		const float* sources[] = { &streams.front()... };
+		for (int vertex = 0; vertex < vertices.size; vertex++)
+		{
+			vertices[vertex].pack(sources, vertex);
+		}
+	}
+
+	// formats on binding 0, vertices read from "offset" on, indices from elementBuffer
+	static GLuint createVertexArray(GLuint vertexBuffer, GLintptr offset, GLuint elementBuffer)
+	{
+		GLuint vao;
+		glGenVertexArrays(1, &vao);
+		glBindVertexArray(vao);
+		Vertex::setupFormat(0, 0);
+		glBindVertexBuffer(0, vertexBuffer, offset, stride);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+		glBindVertexArray(0);
+		return vao;
+	}
+};
+
+#endif //VERTEXLAYOUT_H